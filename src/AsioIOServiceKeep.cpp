@@ -10,20 +10,52 @@
 
 using namespace boost::placeholders;
 
-AsioIOServiceKeep::AsioIOServiceKeep() {
-	work_.reset(new Work(io_service_));
-	thrd_keep_.reset(new boost::thread(boost::bind(&AsioIOServiceKeep::thread_keep, this)));
+boost::mutex AsioIOServiceKeep::mtx_shared_;
+AsioIOServiceKeep::Pointer AsioIOServiceKeep::shared_;
+int AsioIOServiceKeep::nthread_shared_ = 0;
+
+AsioIOServiceKeep::AsioIOServiceKeep(int nthread) {
+	if ((nthread_ = nthread) <= 0) {
+		nthread_ = boost::thread::hardware_concurrency();
+		if (nthread_ <= 0) nthread_ = 1;
+	}
+	io_service_.reset(new IOService);
+	work_.reset(new Work(*io_service_));
+	for (int i = 0; i < nthread_; ++i)
+		thrds_keep_.push_back(ThreadPtr(new boost::thread(boost::bind(&AsioIOServiceKeep::thread_keep, io_service_))));
 }
 
 AsioIOServiceKeep::~AsioIOServiceKeep() {
-	io_service_.stop();
-	thrd_keep_->join();
+	boost::thread::id self = boost::this_thread::get_id();
+
+	work_.reset();
+	io_service_->stop();
+	// 最后一个引用可能在io_service线程内释放. 此时分离该线程, 由其持有的引用维持io_service
+	for (size_t i = 0; i < thrds_keep_.size(); ++i) {
+		if (thrds_keep_[i]->get_id() == self) thrds_keep_[i]->detach();
+		else thrds_keep_[i]->join();
+	}
+}
+
+void AsioIOServiceKeep::ConfigShared(int nthread) {
+	MtxLck lck(mtx_shared_);
+	nthread_shared_ = nthread;
+}
+
+AsioIOServiceKeep::Pointer AsioIOServiceKeep::Shared() {
+	MtxLck lck(mtx_shared_);
+	if (!shared_.use_count()) shared_ = Create(nthread_shared_);
+	return shared_;
 }
 
 AsioIOServiceKeep::IOService& AsioIOServiceKeep::GetIOService() {
-	return io_service_;
+	return *io_service_;
+}
+
+int AsioIOServiceKeep::ThreadCount() {
+	return nthread_;
 }
 
-void AsioIOServiceKeep::thread_keep() {
-	io_service_.run();
+void AsioIOServiceKeep::thread_keep(IOServicePtr io_service) {
+	io_service->run();
 }
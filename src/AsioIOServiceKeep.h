@@ -7,35 +7,90 @@
  * @li boost::asio::io_service::run()在响应所注册的异步调用后自动退出. 为了避免退出run()函数,
  * 建立ioservice_keep维护其长期有效性
  * @li 使用shared_ptr管理指针
+ * @version 0.2
+ * @date 2026-10-16
+ * @note
+ * @li 支持多线程运行同一io_service, 线程数可配置
+ * @li 提供进程内共享实例. TcpClient/TcpServer/AsioUDP/SerialComm可挂接同一实例,
+ * 避免每个连接独占一个线程
+ * @li io_service由线程组共同持有. 最后一个引用在io_service线程内释放时, 该线程被分离,
+ * io_service在其退出run()后释放
  */
 
 #ifndef SRC_ASIOIOSERVICEKEEP_H_
 #define SRC_ASIOIOSERVICEKEEP_H_
 
 #include <boost/asio/io_service.hpp>
+#include <boost/asio/strand.hpp>
 #include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
 #include <boost/smart_ptr/shared_ptr.hpp>
+#include <vector>
 
 class AsioIOServiceKeep {
 public:
 	using IOService = boost::asio::io_service;
+	using Strand = IOService::strand;	///< 串行化同一连接的回调函数
+	using Pointer = boost::shared_ptr<AsioIOServiceKeep>;
 
 protected:
 	using Work = IOService::work;
 	using WorkPtr = boost::shared_ptr<Work>;
+	using MtxLck = boost::unique_lock<boost::mutex>;
+	using IOServicePtr = boost::shared_ptr<IOService>;
 	using ThreadPtr = boost::shared_ptr<boost::thread>;
 	/* 成员变量 */
-	IOService io_service_;
+	IOServicePtr io_service_;	///< 由线程组共同持有
 	WorkPtr work_;
-	ThreadPtr thrd_keep_;
+	std::vector<ThreadPtr> thrds_keep_;	///< 运行io_service的线程组
+	int nthread_;		///< 线程数
+
+	/* 共享实例 */
+	static boost::mutex mtx_shared_;	///< 互斥锁: 共享实例
+	static Pointer shared_;				///< 共享实例
+	static int nthread_shared_;			///< 共享实例线程数
 
 public:
-	AsioIOServiceKeep();
+	/*!
+	 * @brief 构造函数
+	 * @param nthread 运行io_service的线程数. <= 0时使用CPU核数
+	 */
+	AsioIOServiceKeep(int nthread = 1);
 	virtual ~AsioIOServiceKeep();
+	/*!
+	 * @brief 创建实例
+	 * @param nthread 运行io_service的线程数. <= 0时使用CPU核数
+	 * @return
+	 * 实例指针
+	 */
+	static Pointer Create(int nthread = 1) {
+		return Pointer(new AsioIOServiceKeep(nthread));
+	}
+	/*!
+	 * @brief 设置共享实例的线程数
+	 * @param nthread 线程数. <= 0时使用CPU核数
+	 * @note
+	 * 仅在首次调用Shared()之前有效
+	 */
+	static void ConfigShared(int nthread);
+	/*!
+	 * @brief 查看进程内共享实例. 首次调用时创建
+	 * @return
+	 * 共享实例指针
+	 */
+	static Pointer Shared();
 	IOService& GetIOService();
+	/*!
+	 * @brief 查看运行io_service的线程数
+	 */
+	int ThreadCount();
 
 protected:
-	void thread_keep();
+	/*!
+	 * @brief 运行io_service. 线程持有io_service的引用, 直至退出run()
+	 */
+	static void thread_keep(IOServicePtr io_service);
 };
+using IOKeepPtr = AsioIOServiceKeep::Pointer;
 
 #endif /* SRC_ASIOIOSERVICEKEEP_H_ */
@@ -5,6 +5,7 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/bind/bind.hpp>
 #include <boost/asio/placeholders.hpp>
+#include <boost/asio/write.hpp>
 #include "AsioTCP.h"
 
 using namespace boost::system;
@@ -14,15 +15,18 @@ using std::string;
 
 /////////////////////////////////////////////////////////////////////
 /*--------------------- 客户端 ---------------------*/
-TcpClient::TcpClient(bool modeAsync)
-	: sock_(keep_.GetIOService()) {
+TcpClient::TcpClient(bool modeAsync, IOKeepPtr keep)
+	: keep_(keep.use_count() ? keep : AsioIOServiceKeep::Create()),
+	  strand_(keep_->GetIOService()),
+	  sock_(keep_->GetIOService()) {
 	mode_async_ = modeAsync;
 	byte_read_  = 0;
 	buf_read_.reset(new char[TCP_PACK_SIZE]);
-	if (mode_async_) {
-		crcbuf_read_.set_capacity(TCP_PACK_SIZE * 50);
-		crcbuf_write_.set_capacity(TCP_PACK_SIZE * 50);
-	}
+	if (mode_async_) crcbuf_read_.set_capacity(TCP_PACK_SIZE * 50);
+	wrq_sending_ = 0;
+	high_water_  = TCP_HIGH_WATER;
+	low_water_   = TCP_LOW_WATER;
+	wrq_blocked_ = false;
 }
 
 TcpClient::~TcpClient() {
@@ -35,14 +39,14 @@ TcpClient::TCP::socket& TcpClient::Socket() {
 
 bool TcpClient::Connect(const std::string& host, const uint16_t port) {
 	try {
-		TCP::resolver resolver(keep_.GetIOService());
+		TCP::resolver resolver(keep_->GetIOService());
 		TCP::resolver::query query(host, boost::lexical_cast<string>(port));
 		TCP::resolver::iterator itertor = resolver.resolve(query);
 
 		if (mode_async_) {
 			sock_.async_connect(*itertor,
-					boost::bind(&TcpClient::handle_connect, shared_from_this(),
-						placeholders::error));
+					strand_.wrap(boost::bind(&TcpClient::handle_connect, shared_from_this(),
+						placeholders::error)));
 		}
 		else {
 			sock_.connect(*itertor);
@@ -88,13 +92,8 @@ int TcpClient::Read(char* data, const int n, const int from) {
 	MtxLck lck(mtx_read_);
 	int end(from + n), to_read;
 	if (mode_async_) {
-		to_read = crcbuf_read_.size() > end ? n : crcbuf_read_.size() - from;
-		if (to_read) {
-			int i, j;
-			for (i = 0, j = from; i < to_read; ++i, ++j)
-				data[i] = crcbuf_read_[j];
-			crcbuf_read_.erase_begin(end);
-		}
+		to_read = crcbuf_read_.copy(data, n, from);
+		if (to_read) crcbuf_read_.erase_begin(end);
 	}
 	else {
 		to_read = byte_read_ > end ? n : byte_read_ - from;
@@ -113,11 +112,24 @@ int TcpClient::Write(const char* data, const int n) {
 	MtxLck lck(mtx_write_);
 	int had_write(n);
 	if (mode_async_) {
-		int wait_write(crcbuf_write_.size());
-		for (int i = 0; i < n; ++i)
-			crcbuf_write_.push_back(data[i]);
-		if (!wait_write)
-			start_write();
+		if (!accept_write()) return 0;
+		// 追加至队尾未发送的自有数据块, 否则新建数据块
+		int size = wrq_.size();
+		if (size > wrq_sending_ && wrq_.back().capacity - wrq_.back().end >= n) {
+			WriteChunk& chunk = wrq_.back();
+			memcpy(chunk.buff.get() + chunk.end, data, n);
+			chunk.end += n;
+		}
+		else {
+			WriteChunk chunk;
+			chunk.capacity = n > TCP_CHUNK_SIZE ? n : TCP_CHUNK_SIZE;
+			chunk.buff.reset(new char[chunk.capacity]);
+			chunk.begin = 0;
+			chunk.end   = n;
+			memcpy(chunk.buff.get(), data, n);
+			wrq_.push_back(chunk);
+		}
+		queued_write(n);
 	}
 	else {
 		had_write = sock_.write_some(buffer(data, n));
@@ -125,6 +137,33 @@ int TcpClient::Write(const char* data, const int n) {
 	return had_write;
 }
 
+int TcpClient::Write(const CBuff& data, const int n, const int offset) {
+	if (!data || n <= 0 || offset < 0 || !mode_async_)
+		return 0;
+
+	MtxLck lck(mtx_write_);
+	if (!accept_write()) return 0;
+	WriteChunk chunk;
+	chunk.buff     = data;
+	chunk.capacity = 0;
+	chunk.begin    = offset;
+	chunk.end      = offset + n;
+	wrq_.push_back(chunk);
+	queued_write(n);
+	return n;
+}
+
+void TcpClient::SetWaterMark(const int high, const int low) {
+	MtxLck lck(mtx_write_);
+	high_water_ = high > 0 ? high : TCP_HIGH_WATER;
+	low_water_  = (low >= 0 && low < high_water_) ? low : high_water_ / 4;
+}
+
+TcpClient::WriteStats TcpClient::GetWriteStats() {
+	MtxLck lck(mtx_write_);
+	return wrstat_;
+}
+
 int TcpClient::Lookup(char* first) {
 	MtxLck lck(mtx_read_);
 	int n = mode_async_ ? crcbuf_read_.size() : byte_read_;
@@ -137,23 +176,14 @@ int TcpClient::Lookup(const char* flag, const int n, const int from) {
 		return -1;
 
 	MtxLck lck(mtx_read_);
-	int end = (mode_async_ ? crcbuf_read_.size() : byte_read_) - n;
-	int pos, i(0), j;
+	size_t pos;
 
-	if (mode_async_) {
-		for (pos = from; pos <= end; ++pos) {
-			for (i = 0, j = pos; i < n && flag[i] == crcbuf_read_[j]; ++i, ++j);
-			if (i == n) break;
-		}
-	}
-	else {
-		for (pos = from; pos <= end; ++pos) {
-			for (i = 0, j = pos; i < n && flag[i] == buf_read_[j]; ++i, ++j);
-			if (i == n) break;
-		}
-	}
+	if (mode_async_) pos = crcbuf_read_.find(flag, n, from);
+	else if (from >= byte_read_) pos = CRCBuff::npos;
+	else if ((pos = CRCBuff::search(buf_read_.get() + from, byte_read_ - from, flag, n)) != CRCBuff::npos)
+		pos += from;
 
-	return (i == n ? pos : -1);
+	return (pos == CRCBuff::npos ? -1 : int(pos));
 }
 
 void TcpClient::Start() {
@@ -176,20 +206,64 @@ void TcpClient::RegisterWrite(const CBSlot& slot) {
 	cbwrite_.connect(slot);
 }
 
+void TcpClient::RegisterWritable(const CBSlot& slot) {
+	cbwritable_.disconnect_all_slots();
+	cbwritable_.connect(slot);
+}
+
+void TcpClient::SetFramer(TcpFramerPtr framer) {
+	MtxLck lck(mtx_read_);
+	framer_ = framer;
+}
+
+void TcpClient::RegisterFrame(const FrameSlot& slot) {
+	cbframe_.disconnect_all_slots();
+	cbframe_.connect(slot);
+}
+
+bool TcpClient::deliver_frames(const char* data, int n) {
+	return framer_->Feed(crcbuf_read_, data, size_t(n), frames_, [this](FrameVec& frames) {
+		cbframe_(shared_from_this(), frames);
+	});
+}
+
 void TcpClient::start_read() {
 	if (sock_.is_open()) {
 		sock_.async_read_some(buffer(buf_read_.get(), TCP_PACK_SIZE),
-				boost::bind(&TcpClient::handle_read, shared_from_this(),
-					placeholders::error, placeholders::bytes_transferred));
+				strand_.wrap(boost::bind(&TcpClient::handle_read, shared_from_this(),
+					placeholders::error, placeholders::bytes_transferred)));
 	}
 }
 
+bool TcpClient::accept_write() {
+	if (wrstat_.bytes >= high_water_) {
+		wrq_blocked_ = true;
+		++wrstat_.rejected;
+		return false;
+	}
+	return true;
+}
+
+void TcpClient::queued_write(const int n) {
+	wrstat_.bytes += n;
+	wrstat_.depth = wrq_.size();
+	if (wrstat_.bytes > wrstat_.bytes_max) wrstat_.bytes_max = wrstat_.bytes;
+	if (wrstat_.depth > wrstat_.depth_max) wrstat_.depth_max = wrstat_.depth;
+	if (!wrq_sending_) start_write();
+}
+
 void TcpClient::start_write() {
-	int towrite(crcbuf_write_.size());
-	if (towrite) {
-		sock_.async_write_some(buffer(crcbuf_write_.linearize(), towrite),
-				boost::bind(&TcpClient::handle_write, shared_from_this(),
-					placeholders::error, placeholders::bytes_transferred));
+	int size = wrq_.size();
+	if (size) {
+		WriteQueue::iterator it = wrq_.begin();
+		if (size > TCP_GATHER_MAX) size = TCP_GATHER_MAX;
+		wrbufs_.clear();
+		for (int i = 0; i < size; ++i, ++it)
+			wrbufs_.push_back(buffer(it->buff.get() + it->begin, it->end - it->begin));
+		wrq_sending_ = size;
+		async_write(sock_, wrbufs_,
+				strand_.wrap(boost::bind(&TcpClient::handle_write, shared_from_this(),
+					placeholders::error, placeholders::bytes_transferred)));
 	}
 }
 
@@ -203,31 +277,51 @@ void TcpClient::handle_connect(const error_code& ec) {
 }
 
 void TcpClient::handle_read(const error_code& ec, int n) {
+	bool framed(false), valid(true);
 	if (!ec) {
 		MtxLck lck(mtx_read_);
 		if (mode_async_) {
-			for (int i = 0; i < n; ++i)
-				crcbuf_read_.push_back(buf_read_[i]);
+			if ((framed = framer_.use_count() > 0)) valid = deliver_frames(buf_read_.get(), n);
+			else crcbuf_read_.push_back(buf_read_.get(), n);
 		}
 		else byte_read_ = n;
 	}
-	cbread_(shared_from_this(), ec);
+	if (!valid) cbread_(shared_from_this(), error::make_error_code(error::message_size));
+	else if (ec || !framed) cbread_(shared_from_this(), ec);
 	if (!ec) start_read();
 }
 
 void TcpClient::handle_write(const error_code& ec, int n) {
-	if (!ec) {
+	bool writable(false);
+	{
 		MtxLck lck(mtx_write_);
-		crcbuf_write_.erase_begin(n);
-		start_write();
+		if (!ec) {
+			wrq_.erase(wrq_.begin(), wrq_.begin() + wrq_sending_);
+			wrstat_.bytes -= n;
+			wrstat_.sent  += n;
+		}
+		else {// 连接已失效, 丢弃待发送数据
+			wrq_.clear();
+			wrstat_.bytes = 0;
+		}
+		wrstat_.depth = wrq_.size();
+		wrq_sending_  = 0;
+		if (wrq_blocked_ && wrstat_.bytes <= low_water_) {
+			wrq_blocked_ = false;
+			writable = true;
+			++wrstat_.writable;
+		}
+		if (!ec) start_write();
 	}
 	cbwrite_(shared_from_this(), ec);
+	if (writable) cbwritable_(shared_from_this(), ec);
 }
 
 /////////////////////////////////////////////////////////////////////
 /*--------------------- 服务器 ---------------------*/
-TcpServer::TcpServer()
-	: accept_(keep_.GetIOService()) {
+TcpServer::TcpServer(IOKeepPtr keep)
+	: keep_(keep.use_count() ? keep : AsioIOServiceKeep::Create()),
+	  accept_(keep_->GetIOService()) {
 }
 
 TcpServer::~TcpServer() {
@@ -257,8 +351,9 @@ bool TcpServer::CreateServer(uint16_t port, bool v6) {
 
 void TcpServer::start_accept() {
 	if (accept_.is_open()) {
-		TcpCPtr client = TcpClient::Create();
-		accept_.async_accept(client->Socket(), boost::bind(&TcpServer::handle_accept, this, client, placeholders::error));
+		TcpCPtr client = TcpClient::Create(keep_);
+		boost::weak_ptr<TcpServer> server(shared_from_this());
+		accept_.async_accept(client->Socket(), boost::bind(&TcpServer::forward_accept, server, client, placeholders::error));
 	}
 }
 
@@ -270,4 +365,10 @@ void TcpServer::handle_accept(const TcpCPtr client, const error_code& ec) {
 	start_accept();
 }
 
+void TcpServer::forward_accept(const boost::weak_ptr<TcpServer> server, const TcpCPtr client,
+		const error_code& ec) {
+	Pointer ptr = server.lock();
+	if (ptr.use_count()) ptr->handle_accept(client, ec);
+}
+
 /////////////////////////////////////////////////////////////////////
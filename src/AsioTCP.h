@@ -14,6 +14,16 @@
  * @date 2020-10-02
  * @note
  * - 优化
+ * @version 1.1
+ * @date 2026-10-16
+ * @note
+ * - 可挂接共享AsioIOServiceKeep, 由线程池驱动所有连接
+ * - 使用strand保证同一连接的回调函数顺序执行
+ * - 收发缓冲区改用ByteRing, 整段拷贝, 发送时不再linearize()
+ * - Lookup()使用memchr/Boyer-Moore-Horspool查找, 重复查找时仅检查新增数据
+ * - 支持分帧器: 完整帧以接收缓冲区视图形式批量交付
+ * - 发送缓冲区改为引用计数数据块队列, 以async_write聚合发送; 支持高/低水位与可写回调
+ * - TcpClient回调函数改用单目标Callback, 触发时不加锁
  */
 
 #ifndef SRC_ASIOTCP_H_
@@ -22,19 +32,27 @@
 #include <boost/system/error_code.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/signals2/signal.hpp>
-#include <boost/circular_buffer.hpp>
+#include <boost/thread/mutex.hpp>
 #include <boost/smart_ptr/shared_array.hpp>
 #include <boost/enable_shared_from_this.hpp>
 #include <string.h>
 #include <string>
 #include <vector>
+#include <deque>
 #include "AsioIOServiceKeep.h"
+#include "ByteRing.h"
+#include "TcpFramer.h"
+#include "Callback.h"
 
 using namespace boost::system;
 
 /////////////////////////////////////////////////////////////////////
 /*--------------------- 客户端 ---------------------*/
 #define TCP_PACK_SIZE		1500
+#define TCP_CHUNK_SIZE		4096		//< 拷贝写入时发送数据块的最小容量
+#define TCP_HIGH_WATER		1048576		//< 发送队列高水位缺省值
+#define TCP_LOW_WATER		262144		//< 发送队列低水位缺省值
+#define TCP_GATHER_MAX		64			//< 单次聚合发送的最大数据块数
 
 class TcpClient : public boost::enable_shared_from_this<TcpClient> {
 public:
@@ -44,37 +62,93 @@ public:
 	 * @param 1 客户端对象
 	 * @param 2 实例指针
 	 */
-	using CallbackFunc = boost::signals2::signal<void (const Pointer, const error_code&)>;
+	using CallbackFunc = Callback<void (const Pointer, const error_code&)>;
 	using CBSlot = CallbackFunc::slot_type;
+	using FrameVec = std::vector<Frame>;	//< 一次接收的完整帧
+	/*!
+	 * @brief 声明分帧回调函数及插槽
+	 * @param 1 客户端对象
+	 * @param 2 完整帧. 指向接收缓冲区, 仅在回调函数内有效
+	 */
+	using FrameFunc = Callback<void (const Pointer, const FrameVec&)>;
+	using FrameSlot = FrameFunc::slot_type;
 	using TCP = boost::asio::ip::tcp;	// boost::ip::tcp类型
-	using CRCBuff = boost::circular_buffer<char>;	// 字符型循环数组
+	using CRCBuff = ByteRing;	// 字符型循环数组
 	using CBuff = boost::shared_array<char>;	//< char型数组
 	using MtxLck = boost::unique_lock<boost::mutex>;	//< 信号灯互斥锁
 
+	/*!
+	 * @struct WriteStats 发送队列统计
+	 */
+	struct WriteStats {
+		int depth;			//< 当前数据块数
+		int bytes;			//< 当前待发送字节数
+		int depth_max;		//< 数据块数峰值
+		int bytes_max;		//< 待发送字节数峰值
+		int64_t sent;		//< 累计发送字节数
+		int64_t rejected;	//< 因超出高水位被拒绝的写入次数
+		int64_t writable;	//< 可写回调次数
+
+	public:
+		WriteStats() {
+			depth = bytes = depth_max = bytes_max = 0;
+			sent = rejected = writable = 0;
+		}
+	};
+
+protected:
+	/*!
+	 * @struct WriteChunk 发送队列中的数据块
+	 */
+	struct WriteChunk {
+		CBuff buff;		//< 数据. 引用计数, 发送完成后释放
+		int capacity;	//< 容量. 0: 外部数据, 不可追加
+		int begin;		//< 待发送数据起始位置
+		int end;		//< 待发送数据结束位置
+	};
+	using WriteQueue = std::deque<WriteChunk>;
+
 protected:
 	bool mode_async_;		//< 异步读写/模式
-	AsioIOServiceKeep keep_;	//< 提供boost::asio::io_service对象, 并在实例存在期间保持其运行
+	IOKeepPtr keep_;		//< 提供boost::asio::io_service对象, 并在实例存在期间保持其运行
+	AsioIOServiceKeep::Strand strand_;	//< 串行化本连接的回调函数
 	TCP::socket sock_;			//< 套接口
 	boost::mutex mtx_read_;		//< 互斥锁: 从套接口读取
 	boost::mutex mtx_write_;	//< 互斥锁: 向套接口写入
 	CBuff buf_read_;			//< 缓冲区: 单次接收
 	int byte_read_;				//< 单次接收数据长度
 	CRCBuff crcbuf_read_;		//< 缓冲区: 所有接收
-	CRCBuff crcbuf_write_;		//< 缓冲区: 所有待写入
+	WriteQueue wrq_;			//< 发送队列
+	int wrq_sending_;			//< 发送中的数据块数
+	int high_water_;			//< 高水位: 待发送字节数不低于此值时拒绝写入
+	int low_water_;				//< 低水位: 拒绝写入后, 待发送字节数降至此值时触发可写回调
+	bool wrq_blocked_;			//< 已拒绝写入, 等待可写回调
+	WriteStats wrstat_;			//< 发送队列统计
+	std::vector<boost::asio::const_buffer> wrbufs_;	//< 聚合发送缓冲区序列
 	CallbackFunc  cbconn_;	//< connect回调函数
 	CallbackFunc  cbread_;	//< read回调函数
 	CallbackFunc  cbwrite_;	//< write回调函数
+	CallbackFunc  cbwritable_;	//< 发送队列降至低水位回调函数
+	TcpFramerPtr framer_;	//< 分帧器
+	FrameVec frames_;		//< 缓冲区: 一次接收的完整帧
+	FrameFunc cbframe_;		//< 分帧回调函数
 
 public:
-	TcpClient(bool modeAsync = true);
+	/*!
+	 * @brief 构造函数
+	 * @param modeAsync 异步读写模式
+	 * @param keep      io_service线程池. 为空时创建独占实例
+	 */
+	TcpClient(bool modeAsync = true, IOKeepPtr keep = IOKeepPtr());
 	virtual ~TcpClient();
 	/*!
 	 * @brief 创建TcpClient::Pointer实例
+	 * @param keep io_service线程池. 为空时创建独占实例
 	 * @return
 	 * shared_ptr<TcpClient>类型实例指针
 	 */
-	static Pointer Create() {
-		return Pointer(new TcpClient);
+	static Pointer Create(IOKeepPtr keep = IOKeepPtr()) {
+		return Pointer(new TcpClient(true, keep));
 	}
 	/*!
 	 * @brief 查看套接字
@@ -123,9 +197,32 @@ public:
 	 * @param data 待发送数据存储区指针
 	 * @param n    待发送数据长度
 	 * @return
-	 * 实际发送数据长度
+	 * 实际发送数据长度. 异步模式下, 待发送数据超出高水位时拒绝写入并返回0
+	 * @note
+	 * 异步模式下数据被拷贝至发送队列, 调用后即可释放data
 	 */
 	int Write(const char* data, const int n);
+	/*!
+	 * @brief 发送引用计数数据, 不拷贝. 仅异步模式有效
+	 * @param data   待发送数据
+	 * @param n      待发送数据长度
+	 * @param offset 待发送数据在data中的起始位置
+	 * @return
+	 * 接受发送的数据长度. 待发送数据超出高水位时拒绝写入并返回0
+	 * @note
+	 * 发送队列持有data的引用直至发送完成, 调用者不可再修改其内容
+	 */
+	int Write(const CBuff& data, const int n, const int offset = 0);
+	/*!
+	 * @brief 设置发送队列水位
+	 * @param high 高水位, 量纲: 字节
+	 * @param low  低水位, 量纲: 字节
+	 */
+	void SetWaterMark(const int high, const int low);
+	/*!
+	 * @brief 查看发送队列统计
+	 */
+	WriteStats GetWriteStats();
 	/*!
 	 * @brief 查找已接收信息中第一个字符
 	 * @param flag 标识符
@@ -161,14 +258,50 @@ public:
 	 * @param slot 函数插槽
 	 */
 	void RegisterWrite(const CBSlot& slot);
+	/*!
+	 * @brief 注册可写回调函数. 写入因超出高水位被拒绝后, 发送队列降至低水位时调用
+	 * @param slot 函数插槽
+	 */
+	void RegisterWritable(const CBSlot& slot);
+	/*!
+	 * @brief 设置分帧器. 仅异步模式有效
+	 * @param framer 分帧器. 为空时恢复为按接收数据回调
+	 * @note
+	 * 设置分帧器后:
+	 * - 完整帧经RegisterFrame()注册的回调函数交付, 交付后从接收缓冲区清除
+	 * - read回调函数仅在出错时调用. 数据无法分帧或帧长度超出接收缓冲区容量时, 清空接收缓冲区并以message_size错误调用
+	 * - 分帧回调函数持有接收互斥锁, 不可调用Read()/Lookup()
+	 */
+	void SetFramer(TcpFramerPtr framer);
+	/*!
+	 * @brief 注册分帧回调函数, 处理收到的完整帧
+	 * @param slot 函数插槽
+	 */
+	void RegisterFrame(const FrameSlot& slot);
 
 protected:
+	/*!
+	 * @brief 写入接收数据并提取所有完整帧, 交付后清除
+	 * @param data 接收数据
+	 * @param n    数据长度
+	 * @return
+	 * 数据可以分帧
+	 */
+	bool deliver_frames(const char* data, int n);
 	/*!
 	 * @brief 尝试接收网络信息
 	 */
 	void start_read();
 	/*!
-	 * @brief 尝试发送缓冲区数据
+	 * @brief 检查是否接受写入, 更新拒绝统计
+	 */
+	bool accept_write();
+	/*!
+	 * @brief 数据块进入发送队列后更新统计, 必要时启动发送
+	 */
+	void queued_write(const int n);
+	/*!
+	 * @brief 尝试发送队列中的数据块
 	 */
 	void start_write();
 	/* 响应async_函数的回调函数 */
@@ -210,21 +343,28 @@ public:
 	using CBSlot = CallbackFunc::slot_type;
 
 protected:
-	AsioIOServiceKeep keep_;	//< 提供boost::asio::io_service对象, 并在实例存在期间保持其运行
+	IOKeepPtr keep_;		//< 提供boost::asio::io_service对象, 并在实例存在期间保持其运行
 	TCP::acceptor accept_;		//< 网络服务
 	CallbackFunc cbfunc_;		//< 回调函数
 
 public:
-	TcpServer();
+	/*!
+	 * @brief 构造函数
+	 * @param keep io_service线程池. 为空时创建独占实例
+	 * @note
+	 * 服务器接受的客户端与服务器共用同一线程池
+	 */
+	TcpServer(IOKeepPtr keep = IOKeepPtr());
 	virtual ~TcpServer();
 
 	/*!
 	 * @brief 创建一个实例
+	 * @param keep io_service线程池. 为空时创建独占实例
 	 * @return
 	 * 实例指针
 	 */
-	static Pointer Create() {
-		return Pointer(new TcpServer);
+	static Pointer Create(IOKeepPtr keep = IOKeepPtr()) {
+		return Pointer(new TcpServer(keep));
 	}
 
 	/*!
@@ -252,6 +392,14 @@ protected:
 	 * @param ec     错误代码
 	 */
 	void handle_accept(const TcpCPtr client, const boost::system::error_code& ec);
+	/*!
+	 * @brief 转发accept结果. 共享线程池可能在服务器销毁后才执行回调, 因此以弱引用绑定
+	 * @param server 服务器弱引用
+	 * @param client 建立套接字
+	 * @param ec     错误代码
+	 */
+	static void forward_accept(const boost::weak_ptr<TcpServer> server, const TcpCPtr client,
+			const boost::system::error_code& ec);
 };
 using TcpSPtr = boost::shared_ptr<TcpServer>;
 
@@ -12,18 +12,34 @@
 
 #include <boost/bind/bind.hpp>
 #include <boost/asio/placeholders.hpp>
+#include <boost/asio/ip/multicast.hpp>
+#if !defined(WINDOWS)
+#include <net/if.h>
+#endif
+#if defined(__linux__)
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
 #include "AsioUDP.h"
 
 using namespace boost::system;
 using namespace boost::asio;
 using namespace boost::placeholders;
 
-AsioUDP::AsioUDP()
-	: sock_(keep_.GetIOService()) {
+AsioUDP::AsioUDP(IOKeepPtr keep)
+	: keep_(keep.use_count() ? keep : AsioIOServiceKeep::Create()),
+	  strand_(keep_->GetIOService()),
+	  sock_(keep_->GetIOService()) {
 	connected_  = false;
-	byte_read_  = 0;
-	buf_read_.reset(new char[UDP_PACK_SIZE]);
+	received_ = dropped_ = 0;
 	block_reading_ = false;
+	SetQueueSize(UDP_QUEUE_SIZE);
+
+	pool_write_.reset(new char[UDP_SEND_SLOTS * UDP_PACK_SIZE]);
+	slots_free_.reserve(UDP_SEND_SLOTS);
+	for (int i = UDP_SEND_SLOTS - 1; i >= 0; --i) slots_free_.push_back(i);
+	send_rejected_ = 0;
+	peer_port_ = 0;
 }
 
 AsioUDP::~AsioUDP() {
@@ -74,10 +90,72 @@ bool AsioUDP::Connect(const string& ipPeer, const uint16_t port) {
 	return true;
 }
 
+bool AsioUDP::OpenMulticast(const string& group, const uint16_t port, const string& iface) {
+	error_code ec;
+	ip::address addr = ip::address::from_string(group, ec);
+	if (ec || !addr.is_multicast()) return false;
+
+	UDP::endpoint end(addr.is_v6() ? UDP::v6() : UDP::v4(), port);
+	sock_.open(end.protocol(), ec);
+	if (!ec) sock_.set_option(UDP::socket::reuse_address(true), ec);
+	if (!ec) sock_.bind(end, ec);
+	if (ec || !group_option(true, group, iface)) {
+		Close();
+		return false;
+	}
+	start_read();
+	return true;
+}
+
+bool AsioUDP::JoinGroup(const string& group, const string& iface) {
+	return group_option(true, group, iface);
+}
+
+bool AsioUDP::LeaveGroup(const string& group, const string& iface) {
+	return group_option(false, group, iface);
+}
+
+bool AsioUDP::SetMulticast(const int ttl, const bool loopback, const string& iface) {
+	if (!sock_.is_open()) return false;
+
+	error_code ec;
+	sock_.set_option(ip::multicast::hops(ttl), ec);
+	if (!ec) sock_.set_option(ip::multicast::enable_loopback(loopback), ec);
+	if (!ec && !iface.empty()) {
+		UDP::endpoint local = sock_.local_endpoint(ec);
+		if (!ec && local.address().is_v6()) {
+#if !defined(WINDOWS)
+			sock_.set_option(ip::multicast::outbound_interface(if_nametoindex(iface.c_str())), ec);
+#endif
+		}
+		else if (!ec) {
+			ip::address_v4 addr = ip::address_v4::from_string(iface, ec);
+			if (!ec) sock_.set_option(ip::multicast::outbound_interface(addr), ec);
+		}
+	}
+	return !ec;
+}
+
+void AsioUDP::SetQueueSize(const int n) {
+	MtxLck lck(mtx_read_);
+	int size = n > 0 ? n : UDP_QUEUE_SIZE;
+	pool_read_.reset(new char[size * UDP_PACK_SIZE]);
+	pkts_.resize(size);
+	for (int i = 0; i < size; ++i) {
+		pkts_[i].data = pool_read_.get() + i * UDP_PACK_SIZE;
+		pkts_[i].n = 0;
+	}
+	pkt_head_ = pkt_count_ = 0;
+}
+
 const char *AsioUDP::Read(char *buff, int &n) {
 	MtxLck lck(mtx_read_);
-	if ((n = byte_read_)) memcpy(buff, buf_read_.get(), n);
-	return n == 0 ? NULL : buff;
+	return pop_packet(buff, n, NULL);
+}
+
+const char *AsioUDP::ReadFrom(char *buff, int &n, UDP::endpoint &peer) {
+	MtxLck lck(mtx_read_);
+	return pop_packet(buff, n, &peer);
 }
 
 const char* AsioUDP::BlockRead(char *buff, int& n, const int millisec) {
@@ -85,31 +163,97 @@ const char* AsioUDP::BlockRead(char *buff, int& n, const int millisec) {
 	boost::posix_time::milliseconds t(millisec);
 
 	block_reading_ = true;
-	cvread_.timed_wait(lck, t);
-	if ((n = byte_read_)) memcpy(buff, buf_read_.get(), n);
-	return n == 0 ? NULL : buff;
+	if (!pkt_count_) cvread_.timed_wait(lck, t);
+	return pop_packet(buff, n, NULL);
 }
 
-void AsioUDP::Write(const void *data, const int n) {
+int AsioUDP::Available() {
+	MtxLck lck(mtx_read_);
+	return pkt_count_;
+}
+
+int64_t AsioUDP::GetReceived() {
+	MtxLck lck(mtx_read_);
+	return received_;
+}
+
+int64_t AsioUDP::GetDropped() {
+	MtxLck lck(mtx_read_);
+	return dropped_;
+}
+
+bool AsioUDP::Write(const void *data, const int n) {
 	MtxLck lck(mtx_write_);
-	if (connected_) {
-		sock_.async_send(buffer(data, n),
-				boost::bind(&AsioUDP::handle_write, this,
-						placeholders::error, placeholders::bytes_transferred));
-	}
-	else {
-		sock_.async_send_to(buffer(data, n), remote_,
-				boost::bind(&AsioUDP::handle_write, this,
-						placeholders::error, placeholders::bytes_transferred));
+	return send_slot(NULL, data, n);
+}
+
+bool AsioUDP::WriteTo(const string& ipPeer, const uint16_t portPeer, const void *data, int n) {
+	MtxLck lck(mtx_write_);
+	if (portPeer != peer_port_ || ipPeer != peer_ip_) {
+		if (!Endpoint(ipPeer, portPeer, peer_end_)) return false;
+		peer_ip_   = ipPeer;
+		peer_port_ = portPeer;
 	}
+	return send_slot(&peer_end_, data, n);
 }
 
-void AsioUDP::WriteTo(const string& ipPeer, const uint16_t portPeer, const void *data, int n) {
+bool AsioUDP::WriteTo(const UDP::endpoint& peer, const void *data, int n) {
 	MtxLck lck(mtx_write_);
-	UDP::endpoint end(ip::address::from_string(ipPeer), portPeer);
-	sock_.async_send_to(buffer(data, n), end,
-			boost::bind(&AsioUDP::handle_write, this,
-					placeholders::error, placeholders::bytes_transferred));
+	return send_slot(&peer, data, n);
+}
+
+bool AsioUDP::Endpoint(const string& ipPeer, const uint16_t portPeer, UDP::endpoint& peer) {
+	error_code ec;
+	ip::address addr = ip::address::from_string(ipPeer, ec);
+	if (!ec) peer = UDP::endpoint(addr, portPeer);
+	return !ec;
+}
+
+int64_t AsioUDP::GetSendRejected() {
+	MtxLck lck(mtx_write_);
+	return send_rejected_;
+}
+
+int AsioUDP::WriteBatch(const Datagram *dgrams, const int count) {
+	if (!dgrams || count <= 0 || !sock_.is_open()) return 0;
+
+	MtxLck lck(mtx_write_);
+	int sent(0);
+#if defined(__linux__)
+	struct mmsghdr msgs[UDP_BATCH_SIZE];
+	struct iovec iovs[UDP_BATCH_SIZE];
+	int fd = sock_.native_handle();
+
+	while (sent < count) {
+		int i, batch = count - sent, rslt;
+		if (batch > UDP_BATCH_SIZE) batch = UDP_BATCH_SIZE;
+		memset(msgs, 0, sizeof(struct mmsghdr) * batch);
+		for (i = 0; i < batch; ++i) {
+			const Datagram &dgram = dgrams[sent + i];
+			const UDP::endpoint *peer = dgram.peer ? dgram.peer : (connected_ ? NULL : &remote_);
+			iovs[i].iov_base = const_cast<void*>(dgram.data);
+			iovs[i].iov_len  = dgram.n;
+			msgs[i].msg_hdr.msg_iov    = &iovs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+			if (peer) {
+				msgs[i].msg_hdr.msg_name    = const_cast<sockaddr*>(peer->data());
+				msgs[i].msg_hdr.msg_namelen = peer->size();
+			}
+		}
+		if ((rslt = sendmmsg(fd, msgs, batch, MSG_DONTWAIT)) <= 0) break;
+		sent += rslt;
+		if (rslt < batch) break;
+	}
+#else
+	error_code ec;
+	for (; sent < count; ++sent) {
+		const Datagram &dgram = dgrams[sent];
+		if (!dgram.peer && connected_) sock_.send(buffer(dgram.data, dgram.n), 0, ec);
+		else sock_.send_to(buffer(dgram.data, dgram.n), dgram.peer ? *dgram.peer : remote_, 0, ec);
+		if (ec) break;
+	}
+#endif
+	return sent;
 }
 
 void AsioUDP::RegisterConnect(const CBSlot &slot) {
@@ -125,28 +269,249 @@ void AsioUDP::RegisterWrite(const CBSlot &slot) {
 }
 
 void AsioUDP::start_read() {
-	if (connected_) {
-		sock_.async_receive(buffer(buf_read_.get(), UDP_PACK_SIZE),
-				boost::bind(&AsioUDP::handle_read, this,
-						placeholders::error, placeholders::bytes_transferred));
+	// 仅等待可读事件, 由receive_batch()一次读出所有数据包
+	sock_.async_receive(null_buffers(),
+			strand_.wrap(boost::bind(&AsioUDP::handle_read, shared_from_this(),
+					placeholders::error, placeholders::bytes_transferred)));
+}
+
+int AsioUDP::receive_batch() {
+	MtxLck lck(mtx_read_);
+	int size(pkts_.size()), total(0);
+	char scratch[UDP_PACK_SIZE];
+
+#if defined(__linux__)
+	struct mmsghdr msgs[UDP_BATCH_SIZE];
+	struct iovec iovs[UDP_BATCH_SIZE];
+	int fd = sock_.native_handle();
+
+	while (true) {
+		int tail = (pkt_head_ + pkt_count_) % size;
+		int batch = pkt_count_ == size ? UDP_BATCH_SIZE : size - pkt_count_;
+		int i, rslt;
+		bool full = pkt_count_ == size;
+
+		if (!full && batch > size - tail) batch = size - tail;	// 仅使用连续槽位
+		if (batch > UDP_BATCH_SIZE) batch = UDP_BATCH_SIZE;
+		memset(msgs, 0, sizeof(struct mmsghdr) * batch);
+		for (i = 0; i < batch; ++i) {
+			Packet &pkt = pkts_[tail + (full ? 0 : i)];
+			iovs[i].iov_base = full ? scratch : pkt.data;	// 队列满时读出并丢弃
+			iovs[i].iov_len  = UDP_PACK_SIZE;
+			msgs[i].msg_hdr.msg_iov     = &iovs[i];
+			msgs[i].msg_hdr.msg_iovlen  = 1;
+			msgs[i].msg_hdr.msg_name    = full ? NULL : pkt.peer.data();
+			msgs[i].msg_hdr.msg_namelen = full ? 0 : pkt.peer.capacity();
+		}
+		if ((rslt = recvmmsg(fd, msgs, batch, MSG_DONTWAIT, NULL)) <= 0) break;
+		if (full) dropped_ += rslt;
+		else {
+			for (i = 0; i < rslt; ++i) {
+				Packet &pkt = pkts_[tail + i];
+				pkt.n = msgs[i].msg_len;
+				if (connected_) pkt.peer = remote_;
+				else pkt.peer.resize(msgs[i].msg_hdr.msg_namelen);
+			}
+			pkt_count_ += rslt;
+			total += rslt;
+		}
+		received_ += rslt;
+		if (rslt < batch) break;
 	}
-	else {
-		sock_.async_receive_from(buffer(buf_read_.get(), UDP_PACK_SIZE), remote_,
-				boost::bind(&AsioUDP::handle_read, this,
-						placeholders::error, placeholders::bytes_transferred));
+#else
+	error_code ec;
+	UDP::endpoint peer;
+	int n;
+
+	sock_.non_blocking(true, ec);
+	while (true) {
+		bool full = pkt_count_ == size;
+		Packet &pkt = pkts_[(pkt_head_ + pkt_count_) % size];
+		char *data = full ? scratch : pkt.data;
+
+		if (connected_) n = sock_.receive(buffer(data, UDP_PACK_SIZE), 0, ec);
+		else n = sock_.receive_from(buffer(data, UDP_PACK_SIZE), peer, 0, ec);
+		if (ec && ec != error::message_size) break;
+		++received_;
+		if (full) ++dropped_;
+		else {
+			pkt.n = n;
+			pkt.peer = connected_ ? remote_ : peer;
+			++pkt_count_;
+			++total;
+		}
+	}
+#endif
+	if (total && !connected_) {// 缺省回复最近一次接收的来源
+		MtxLck lck_write(mtx_write_);
+		remote_ = pkts_[(pkt_head_ + pkt_count_ - 1) % size].peer;
 	}
+	return total;
 }
 
-void AsioUDP::handle_read(const error_code& ec, const int n) {
-	if (!ec || ec == error::message_size) {
-		byte_read_ = n;
-		if (block_reading_) cvread_.notify_one();
-		else cbread_(shared_from_this(), ec);
+const char *AsioUDP::pop_packet(char *buff, int &n, UDP::endpoint *peer) {
+	if (!pkt_count_) {
+		n = 0;
+		return NULL;
+	}
+	Packet &pkt = pkts_[pkt_head_];
+	memcpy(buff, pkt.data, n = pkt.n);
+	if (peer) *peer = pkt.peer;
+	pkt_head_ = (pkt_head_ + 1) % pkts_.size();
+	--pkt_count_;
+	return buff;
+}
+
+void AsioUDP::handle_read(const error_code& ec, const int) {
+	if (!ec) {
+		if (receive_batch()) {
+			if (block_reading_) cvread_.notify_all();
+			else cbread_(shared_from_this(), ec);
+		}
 		start_read();
 	}
 }
 
-void AsioUDP::handle_write(const error_code& ec, const int n) {
-	printf ("ec = %s\n", ec.message().c_str());
+bool AsioUDP::group_option(const bool join, const string& group, const string& iface) {
+	if (!sock_.is_open()) return false;
+
+	error_code ec;
+	ip::address addr = ip::address::from_string(group, ec);
+	if (ec || !addr.is_multicast()) return false;
+
+	if (addr.is_v6()) {
+		unsigned long index(0);
+#if !defined(WINDOWS)
+		if (!iface.empty()) index = if_nametoindex(iface.c_str());
+#endif
+		if (join) sock_.set_option(ip::multicast::join_group(addr.to_v6(), index), ec);
+		else sock_.set_option(ip::multicast::leave_group(addr.to_v6(), index), ec);
+	}
+	else {
+		ip::address_v4 local = ip::address_v4::any();
+		if (!iface.empty()) local = ip::address_v4::from_string(iface, ec);
+		if (!ec) {
+			if (join) sock_.set_option(ip::multicast::join_group(addr.to_v4(), local), ec);
+			else sock_.set_option(ip::multicast::leave_group(addr.to_v4(), local), ec);
+		}
+	}
+	return !ec;
+}
+
+bool AsioUDP::send_slot(const UDP::endpoint *peer, const void *data, const int n) {
+	if (!data || n <= 0 || n > UDP_DGRAM_SIZE || (n <= UDP_PACK_SIZE && slots_free_.empty())) {
+		++send_rejected_;
+		return false;
+	}
+
+	int slot(-1);
+	CBuff buff;
+	char *ptr;
+	if (n <= UDP_PACK_SIZE) {
+		slot = slots_free_.back();
+		ptr  = pool_write_.get() + slot * UDP_PACK_SIZE;
+		slots_free_.pop_back();
+	}
+	else {// 超长数据: 临时缓冲区
+		buff.reset(new char[n]);
+		ptr = buff.get();
+	}
+	memcpy(ptr, data, n);
+	if (!peer && connected_) {
+		sock_.async_send(buffer(ptr, n),
+				strand_.wrap(boost::bind(&AsioUDP::handle_write, shared_from_this(),
+						placeholders::error, placeholders::bytes_transferred, slot, buff)));
+	}
+	else {
+		sock_.async_send_to(buffer(ptr, n), peer ? *peer : remote_,
+				strand_.wrap(boost::bind(&AsioUDP::handle_write, shared_from_this(),
+						placeholders::error, placeholders::bytes_transferred, slot, buff)));
+	}
+	return true;
+}
+
+void AsioUDP::handle_write(const error_code& ec, const int, const int slot, CBuff) {
+	if (slot >= 0) {
+		MtxLck lck(mtx_write_);
+		slots_free_.push_back(slot);
+	}
 	cbwrite_(shared_from_this(), ec);
 }
+
+/////////////////////////////////////////////////////////////////////
+UdpPublisher::UdpPublisher(UdpCPtr udp, const string& ipPeer, const uint16_t port, const int mtu)
+	: udp_(udp) {
+	error_code ec;
+	ip::address addr = ip::address::from_string(ipPeer, ec);
+	if (!ec) peer_ = AsioUDP::UDP::endpoint(addr, port);
+	mtu_  = (mtu > 2 && mtu <= UDP_PACK_SIZE) ? mtu : UDP_PAYLOAD_MTU;
+	size_ = pending_ = 0;
+	records_ = datagrams_ = 0;
+	dropRecords_ = dropDatagrams_ = 0;
+	buff_.reset(new char[mtu_]);
+}
+
+bool UdpPublisher::Append(const void *rec, const int n) {
+	if (!rec || n < 0 || n + 2 > mtu_) return false;
+
+	MtxLck lck(mtx_);
+	if (size_ + n + 2 > mtu_) flush();
+	char *ptr = buff_.get() + size_;
+	ptr[0] = char((n >> 8) & 0xFF);
+	ptr[1] = char(n & 0xFF);
+	memcpy(ptr + 2, rec, n);
+	size_ += n + 2;
+	++pending_;
+	return true;
+}
+
+int UdpPublisher::Flush() {
+	MtxLck lck(mtx_);
+	return flush();
+}
+
+int64_t UdpPublisher::GetRecords() {
+	MtxLck lck(mtx_);
+	return records_;
+}
+
+int64_t UdpPublisher::GetDatagrams() {
+	MtxLck lck(mtx_);
+	return datagrams_;
+}
+
+void UdpPublisher::GetDropped(int64_t &records, int64_t &datagrams) {
+	MtxLck lck(mtx_);
+	records   = dropRecords_;
+	datagrams = dropDatagrams_;
+}
+
+bool UdpPublisher::NextRecord(const char *data, const int n, int &pos, const char *&rec, int &len) {
+	if (!data || pos < 0 || pos + 2 > n) return false;
+	len = ((unsigned char) data[pos] << 8) | (unsigned char) data[pos + 1];
+	if (pos + 2 + len > n) return false;
+	rec = data + pos + 2;
+	pos += len + 2;
+	return true;
+}
+
+int UdpPublisher::flush() {
+	int n(size_);
+	if (n) {
+		AsioUDP::Datagram dgram;
+		dgram.data = buff_.get();
+		dgram.n    = n;
+		dgram.peer = &peer_;
+		if (udp_->WriteBatch(&dgram, 1) == 1) {
+			++datagrams_;
+			records_ += pending_;
+		}
+		else {// 发送失败, 丢弃已合并记录
+			++dropDatagrams_;
+			dropRecords_ += pending_;
+			n = 0;
+		}
+		size_ = pending_ = 0;
+	}
+	return n;
+}
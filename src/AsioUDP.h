@@ -8,6 +8,19 @@
  * @date Oct 30, 2020
  * @note
  * - 优化
+ * @version 0.3
+ * @date Oct 16, 2026
+ * @note
+ * - 可挂接共享AsioIOServiceKeep
+ * - 使用strand串行化回调函数
+ * - 接收队列: 预分配数据包槽位, Linux下以recvmmsg批量接收, 队列满时丢弃并计数
+ * - WriteBatch(): Linux下以sendmmsg批量发送
+ * - 支持组播: 加入/退出组, TTL, 回环, 出口网卡
+ * - UdpPublisher: 将多条遥测记录合并为一个数据包发送
+ * - Write()/WriteTo()将数据拷贝至预分配的发送槽位, 发送完成后回收. 调用者无需保持数据有效.
+ *   超过UDP_PACK_SIZE的数据(不大于UDP_DGRAM_SIZE)拷贝至临时分配的缓冲区, 不占用槽位
+ * - WriteTo()支持已解析的远程主机地址, 避免重复解析字符串
+ * - 回调函数改用单目标Callback, 触发时不加锁. 注册函数替换已有插槽
  */
 
 #ifndef SRC_ASIOUDP_H_
@@ -15,18 +28,30 @@
 
 #include <boost/system/error_code.hpp>
 #include <boost/asio/ip/udp.hpp>
-#include <boost/signals2.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include <boost/smart_ptr/shared_array.hpp>
 #include <boost/enable_shared_from_this.hpp>
 #include <string>
+#include <vector>
 #include "AsioIOServiceKeep.h"
+#include "Callback.h"
 
 #define UDP_PACK_SIZE		1500
+#define UDP_QUEUE_SIZE		256		//< 接收队列缺省容量, 量纲: 数据包
+#define UDP_BATCH_SIZE		32		//< 单次系统调用收发的最大数据包数
+#define UDP_PAYLOAD_MTU		1472	//< 以太网MTU=1500时不分片的最大载荷
+#define UDP_SEND_SLOTS		64		//< 发送槽位数量, 即可同时等待完成的发送数
+#define UDP_DGRAM_SIZE		65507	//< 单个UDP数据报的最大载荷, 即Write()/WriteTo()的长度上限
 using std::string;
 
 class AsioUDP : public boost::enable_shared_from_this<AsioUDP> {
 public:
-	AsioUDP();
+	/*!
+	 * @brief 构造函数
+	 * @param keep io_service线程池. 为空时创建独占实例
+	 */
+	AsioUDP(IOKeepPtr keep = IOKeepPtr());
 	virtual ~AsioUDP();
 
 public:
@@ -37,21 +62,52 @@ public:
 	 * @param 1 客户端对象
 	 * @param 2 错误描述
 	 */
-	using CallbackFunc = boost::signals2::signal<void (Pointer, const boost::system::error_code&)>;
+	using CallbackFunc = Callback<void (Pointer, const boost::system::error_code&)>;
 	using CBSlot = CallbackFunc::slot_type;
 	using UDP = boost::asio::ip::udp;	// boost::ip::udp类型
 	using CBuff = boost::shared_array<char>;	//< char型数组
 	using MtxLck = boost::unique_lock<boost::mutex>;	//< 信号灯互斥锁
 
+	/*!
+	 * @struct Datagram 批量发送的数据包
+	 */
+	struct Datagram {
+		const void *data;			//< 待发送数据
+		int n;						//< 待发送数据长度, 量纲: 字节
+		const UDP::endpoint *peer;	//< 远程主机. NULL: 已连接主机或最近一次接收的来源
+	};
+
 protected:
-	AsioIOServiceKeep keep_;	//< 提供boost::asio::io_service对象, 并在实例存在期间保持其运行
+	/*!
+	 * @struct Packet 接收队列中的数据包槽位
+	 */
+	struct Packet {
+		char *data;			//< 数据, 指向预分配存储区
+		int n;				//< 数据长度
+		UDP::endpoint peer;	//< 来源
+	};
+	using PacketVec = std::vector<Packet>;
+
+protected:
+	IOKeepPtr keep_;		//< 提供boost::asio::io_service对象, 并在实例存在期间保持其运行
+	AsioIOServiceKeep::Strand strand_;	//< 串行化本实例的回调函数
 	UDP::socket sock_;			//< 套接口
 	UDP::endpoint remote_;		//< 远程套接口
 	bool connected_;			//< 连接标志
 	boost::mutex mtx_read_;		//< 互斥锁: 从套接口读取
 	boost::mutex mtx_write_;	//< 互斥锁: 向套接口写入
-	CBuff buf_read_;			//< 缓冲区: 单次接收
-	int byte_read_;				//< 单次接收数据长度
+	CBuff pool_read_;			//< 接收队列存储区
+	PacketVec pkts_;			//< 接收队列槽位
+	int pkt_head_;				//< 队首槽位
+	int pkt_count_;				//< 队列中数据包数量
+	int64_t received_;			//< 累计接收数据包数量
+	int64_t dropped_;			//< 因队列满而丢弃的数据包数量
+	CBuff pool_write_;			//< 发送槽位存储区
+	std::vector<int> slots_free_;	//< 空闲发送槽位
+	int64_t send_rejected_;		//< 因无空闲槽位或数据过长被拒绝的发送次数
+	string peer_ip_;			//< WriteTo()缓存: 最近一次的远程主机地址
+	uint16_t peer_port_;		//< WriteTo()缓存: 最近一次的远程主机端口
+	UDP::endpoint peer_end_;	//< WriteTo()缓存: 解析结果
 	CallbackFunc cbconn_;	//< 连接回调函数
 	CallbackFunc cbread_;	//< 接收回调函数
 	CallbackFunc cbwrite_;	//< 发送回调函数
@@ -63,9 +119,10 @@ public:
 	/* 接口 */
 	/*!
 	 * @brief 创建对象实例, 并返回其指针
+	 * @param keep io_service线程池. 为空时创建独占实例
 	 */
-	static Pointer Create() {
-		return Pointer(new AsioUDP);
+	static Pointer Create(IOKeepPtr keep = IOKeepPtr()) {
+		return Pointer(new AsioUDP(keep));
 	}
 
 	/*!
@@ -99,13 +156,63 @@ public:
 	 */
 	bool Connect(const string& ipPeer, const uint16_t port);
 	/*!
-	 * @brief 读取已接收数据
-	 * @param buff  存储网络接收数据的缓冲区, 由用户分配存储空间
+	 * @brief 打开端口并加入组播组, 接收组播数据
+	 * @param group 组播地址
+	 * @param port  服务端口
+	 * @param iface 接收网卡. IPv4: 网卡地址; IPv6: 网卡名称. 空: 系统指定
+	 * @return
+	 * 操作结果
+	 * @note
+	 * 设置地址重用, 同一主机上的多个进程可以同时接收
+	 */
+	bool OpenMulticast(const string& group, const uint16_t port, const string& iface = "");
+	/*!
+	 * @brief 加入组播组
+	 * @param group 组播地址
+	 * @param iface 接收网卡. IPv4: 网卡地址; IPv6: 网卡名称. 空: 系统指定
+	 * @return
+	 * 操作结果
+	 */
+	bool JoinGroup(const string& group, const string& iface = "");
+	/*!
+	 * @brief 退出组播组
+	 * @param group 组播地址
+	 * @param iface 接收网卡
+	 * @return
+	 * 操作结果
+	 */
+	bool LeaveGroup(const string& group, const string& iface = "");
+	/*!
+	 * @brief 设置组播发送参数
+	 * @param ttl      生存期(跳数)
+	 * @param loopback 本机是否接收自身发送的组播数据
+	 * @param iface    发送网卡. IPv4: 网卡地址; IPv6: 网卡名称. 空: 系统指定
+	 * @return
+	 * 操作结果
+	 */
+	bool SetMulticast(const int ttl, const bool loopback = true, const string& iface = "");
+	/*!
+	 * @brief 设置接收队列容量. 在Open()/Connect()之前调用
+	 * @param n 容量, 量纲: 数据包
+	 */
+	void SetQueueSize(const int n);
+	/*!
+	 * @brief 读取并移除接收队列中最早的数据包
+	 * @param buff  存储网络接收数据的缓冲区, 由用户分配存储空间, 长度不小于UDP_PACK_SIZE
 	 * @param n     数据长度, 量纲: 字节
 	 * @return
-	 * 存储数据缓冲区地址
+	 * 存储数据缓冲区地址. 队列为空时返回NULL
 	 */
 	const char *Read(char *buff, int &n);
+	/*!
+	 * @brief 读取并移除接收队列中最早的数据包, 同时输出其来源
+	 * @param buff  存储网络接收数据的缓冲区, 由用户分配存储空间, 长度不小于UDP_PACK_SIZE
+	 * @param n     数据长度, 量纲: 字节
+	 * @param peer  数据来源
+	 * @return
+	 * 存储数据缓冲区地址. 队列为空时返回NULL
+	 */
+	const char *ReadFrom(char *buff, int &n, UDP::endpoint &peer);
 	/*!
 	 * @brief 阻塞直至有数据可以读出, 或限时到达
 	 * @param buff     存储网络接收数据的缓冲区, 由用户分配存储空间
@@ -115,20 +222,70 @@ public:
 	 * 可读出数据地址
 	 */
 	const char* BlockRead(char *buff, int& n, const int millisec = 100);
+	/*!
+	 * @brief 查看接收队列中的数据包数量
+	 */
+	int Available();
+	/*!
+	 * @brief 查看累计接收数据包数量
+	 */
+	int64_t GetReceived();
+	/*!
+	 * @brief 查看因接收队列满而丢弃的数据包数量
+	 */
+	int64_t GetDropped();
 	/*!
 	 * @brief 将数据写入套接口
-	 * @param data 待发送数据
-	 * @param n    待发送数据长度, 量纲: 字节
+	 * @param data 待发送数据. 被拷贝至发送槽位, 调用后即可释放
+	 * @param n    待发送数据长度, 量纲: 字节. 不大于UDP_DGRAM_SIZE
+	 * @return
+	 * 数据进入发送流程. 无空闲发送槽位或数据过长时返回false
+	 * @note
+	 * 不大于UDP_PACK_SIZE的数据使用预分配的发送槽位, 更长的数据临时分配缓冲区
 	 */
-	void Write(const void *data, const int n);
+	bool Write(const void *data, const int n);
 	/*!
 	 * @brief 将数据发送给远程主机
 	 * @param ipPeer     远程主机IP地址
 	 * @param portPeer   远程主机端口
-	 * @param data       待发送数据
-	 * @param n          待发送数据长度, 量纲: 字节
+	 * @param data       待发送数据. 被拷贝至发送槽位, 调用后即可释放
+	 * @param n          待发送数据长度, 量纲: 字节. 不大于UDP_DGRAM_SIZE
+	 * @return
+	 * 数据进入发送流程
+	 * @note
+	 * 缓存最近一次的解析结果. 向同一主机重复发送时建议使用Endpoint()构建的地址
+	 */
+	bool WriteTo(const string& ipPeer, const uint16_t portPeer, const void *data, int n);
+	/*!
+	 * @brief 将数据发送给已解析的远程主机
+	 * @param peer 远程主机
+	 * @param data 待发送数据. 被拷贝至发送槽位, 调用后即可释放
+	 * @param n    待发送数据长度, 量纲: 字节. 不大于UDP_DGRAM_SIZE
+	 * @return
+	 * 数据进入发送流程
+	 */
+	bool WriteTo(const UDP::endpoint& peer, const void *data, int n);
+	/*!
+	 * @brief 解析远程主机地址
+	 * @param ipPeer   远程主机IP地址
+	 * @param portPeer 远程主机端口
+	 * @param peer     解析结果
+	 * @return
+	 * 解析结果
+	 */
+	static bool Endpoint(const string& ipPeer, const uint16_t portPeer, UDP::endpoint& peer);
+	/*!
+	 * @brief 查看因无空闲槽位或数据过长被拒绝的发送次数
+	 */
+	int64_t GetSendRejected();
+	/*!
+	 * @brief 以同步非阻塞方式批量发送数据包
+	 * @param dgrams 数据包
+	 * @param count  数据包数量
+	 * @return
+	 * 已发送数据包数量. 发送缓冲区满时小于count
 	 */
-	void WriteTo(const string& ipPeer, const uint16_t portPeer, const void *data, int n);
+	int WriteBatch(const Datagram *dgrams, const int count);
 	/*!
 	 * @brief 注册异步连接回调函数
 	 * @param slot 插槽
@@ -151,18 +308,129 @@ protected:
 	 */
 	void start_read();
 	/*!
-	 * @brief 处理收到的网络信息
+	 * @brief 以非阻塞方式读出套接口中所有数据包, 存入接收队列
+	 * @return
+	 * 存入接收队列的数据包数量
+	 */
+	int receive_batch();
+	/*!
+	 * @brief 从队首取出一个数据包
+	 */
+	const char *pop_packet(char *buff, int &n, UDP::endpoint *peer);
+	/*!
+	 * @brief 处理套接口可读事件
 	 * @param ec 错误代码
-	 * @param n  接收数据长度, 量纲: 字节
+	 * @param n  未使用
 	 */
 	void handle_read(const boost::system::error_code& ec, const int n);
+	/*!
+	 * @brief 拷贝数据至空闲发送槽位并启动发送. 调用者持有发送互斥锁
+	 * @param peer 远程主机. NULL: 已连接主机或最近一次接收的来源
+	 * @note
+	 * 数据长于UDP_PACK_SIZE时拷贝至临时缓冲区, 由完成回调持有至发送结束
+	 */
+	bool send_slot(const UDP::endpoint *peer, const void *data, const int n);
 	/*!
 	 * @brief 处理异步网络信息发送结果
-	 * @param ec 错误代码
-	 * @param n  发送数据长度, 量纲: 字节
+	 * @param ec   错误代码
+	 * @param n    发送数据长度, 量纲: 字节
+	 * @param slot 发送槽位. <0: 临时缓冲区
+	 * @param buff 临时缓冲区, 发送结束后释放
 	 */
-	void handle_write(const boost::system::error_code& ec, const int n);
+	void handle_write(const boost::system::error_code& ec, const int n, const int slot, CBuff buff);
+	/*!
+	 * @brief 构建组播加入/退出选项
+	 * @param join  加入或退出
+	 * @param group 组播地址
+	 * @param iface 接收网卡
+	 * @return
+	 * 操作结果
+	 */
+	bool group_option(const bool join, const string& group, const string& iface);
 };
 using UdpCPtr = AsioUDP::Pointer;
 
+/*!
+ * @class UdpPublisher 合并遥测记录, 以单个数据包发送至组播组或远程主机
+ * @note
+ * 数据包由若干记录顺序构成, 每条记录: 2字节长度(网络字节序) + 记录内容.
+ * 接收方使用NextRecord()拆分
+ */
+class UdpPublisher {
+public:
+	using Pointer = boost::shared_ptr<UdpPublisher>;
+	using MtxLck = boost::unique_lock<boost::mutex>;
+
+protected:
+	UdpCPtr udp_;				//< 发送套接口
+	AsioUDP::UDP::endpoint peer_;	//< 组播组或远程主机
+	boost::mutex mtx_;			//< 互斥锁: 合并缓冲区
+	AsioUDP::CBuff buff_;		//< 合并缓冲区
+	int mtu_;					//< 数据包最大长度
+	int size_;					//< 合并缓冲区已用长度
+	int pending_;				//< 合并缓冲区中的记录数
+	int64_t records_;			//< 累计发送记录数
+	int64_t datagrams_;			//< 累计发送数据包数
+	int64_t dropRecords_;		//< 累计发送失败记录数
+	int64_t dropDatagrams_;		//< 累计发送失败数据包数
+
+public:
+	/*!
+	 * @param udp    已打开的发送套接口
+	 * @param ipPeer 组播地址或远程主机地址
+	 * @param port   目标端口
+	 * @param mtu    数据包最大长度
+	 */
+	UdpPublisher(UdpCPtr udp, const string& ipPeer, const uint16_t port, const int mtu = UDP_PAYLOAD_MTU);
+	static Pointer Create(UdpCPtr udp, const string& ipPeer, const uint16_t port, const int mtu = UDP_PAYLOAD_MTU) {
+		return Pointer(new UdpPublisher(udp, ipPeer, port, mtu));
+	}
+	/*!
+	 * @brief 追加一条记录. 数据包剩余空间不足时先发送已合并记录
+	 * @param rec 记录
+	 * @param n   记录长度
+	 * @return
+	 * 记录被接受. 记录长度超出数据包容量时返回false
+	 */
+	bool Append(const void *rec, const int n);
+	/*!
+	 * @brief 发送已合并记录
+	 * @return
+	 * 发送数据长度
+	 */
+	int Flush();
+	/*!
+	 * @brief 查看累计发送记录数
+	 */
+	int64_t GetRecords();
+	/*!
+	 * @brief 查看累计发送数据包数
+	 */
+	int64_t GetDatagrams();
+	/*!
+	 * @brief 查看发送失败而丢弃的数量, 如非阻塞发送时内核缓冲区已满
+	 * @param records   累计丢弃记录数
+	 * @param datagrams 累计丢弃数据包数
+	 */
+	void GetDropped(int64_t &records, int64_t &datagrams);
+	/*!
+	 * @brief 从数据包中依次取出记录
+	 * @param data 数据包
+	 * @param n    数据包长度
+	 * @param pos  当前位置. 首次调用时置0
+	 * @param rec  记录地址
+	 * @param len  记录长度
+	 * @return
+	 * 取出记录. 数据包已结束或格式错误时返回false
+	 */
+	static bool NextRecord(const char *data, const int n, int &pos, const char *&rec, int &len);
+
+protected:
+	/*!
+	 * @brief 发送已合并记录. 调用者持有互斥锁
+	 */
+	int flush();
+};
+using UdpPubPtr = UdpPublisher::Pointer;
+
 #endif /* SRC_ASIOUDP_H_ */
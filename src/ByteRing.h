@@ -0,0 +1,284 @@
+/**
+ * @file ByteRing.h 字节型循环缓冲区, 支持整段拷贝
+ * @version 0.1
+ * @date 2026-10-16
+ * @note
+ * - 替代boost::circular_buffer<char>用于收发缓冲区
+ * - 数据至多分布在两段连续存储区内, 读写均以memcpy完成
+ * - array_one()/array_two()返回已存数据的两段连续区, 可直接构建asio缓冲区序列,
+ *   无需linearize()
+ * - 缓冲区满时写入新数据覆盖最早的数据, 与boost::circular_buffer::push_back行为一致
+ * - 非线程安全, 由调用者加锁
+ * @version 0.2
+ * @date 2026-10-16
+ * @note
+ * - 增加find(): 单字节标识符使用memchr, 多字节标识符使用Boyer-Moore-Horspool算法.
+ *   跨越存储区尾部时无需linearize()
+ * - find()记录已检查位置, 针对同一标识符重复查找时仅检查新增数据
+ */
+
+#ifndef SRC_BYTERING_H_
+#define SRC_BYTERING_H_
+
+#include <string.h>
+#include <string>
+#include <utility>
+#include <boost/smart_ptr/shared_array.hpp>
+
+class ByteRing {
+public:
+	using array_range = std::pair<char*, size_t>;	///< 连续存储区: 首地址+长度
+	static const size_t npos = size_t(-1);	///< 查找失败
+
+protected:
+	boost::shared_array<char> buff_;	///< 存储区
+	size_t capacity_;	///< 容量
+	size_t head_;		///< 首字节位置
+	size_t size_;		///< 已存数据长度
+	size_t offset_;		///< 首字节在数据流中的位置, 即累计清除的数据长度
+	/* 增量查找 */
+	std::string find_flag_;	///< 上次查找的标识符
+	size_t find_begin_;		///< 上次查找的起始位置, 数据流位置
+	size_t find_next_;		///< [find_begin_, find_next_)内不存在标识符, 数据流位置
+
+public:
+	ByteRing(size_t capacity = 0) {
+		capacity_ = head_ = size_ = offset_ = 0;
+		find_begin_ = find_next_ = 0;
+		set_capacity(capacity);
+	}
+
+	/*!
+	 * @brief 设置容量, 清除已存数据
+	 * @param capacity 容量, 量纲: 字节
+	 */
+	void set_capacity(size_t capacity) {
+		if (capacity != capacity_) {
+			capacity_ = capacity;
+			buff_.reset(capacity ? new char[capacity] : NULL);
+		}
+		clear();
+	}
+
+	size_t capacity() const {
+		return capacity_;
+	}
+
+	size_t size() const {
+		return size_;
+	}
+
+	/*!
+	 * @brief 查看可写入而不覆盖已有数据的长度
+	 */
+	size_t reserve() const {
+		return capacity_ - size_;
+	}
+
+	bool empty() const {
+		return size_ == 0;
+	}
+
+	bool full() const {
+		return size_ == capacity_;
+	}
+
+	void clear() {
+		offset_ += size_;
+		head_ = size_ = 0;
+	}
+
+	/*!
+	 * @brief 查看首字节在数据流中的位置
+	 */
+	size_t offset() const {
+		return offset_;
+	}
+
+	/*!
+	 * @brief 查看第i个字节. 调用者保证i < size()
+	 */
+	char operator[](size_t i) const {
+		return buff_[wrap(head_ + i)];
+	}
+
+	/*!
+	 * @brief 第一段已存数据
+	 */
+	array_range array_one() const {
+		size_t n = capacity_ - head_;
+		return array_range(buff_.get() + head_, size_ < n ? size_ : n);
+	}
+
+	/*!
+	 * @brief 第二段已存数据. 数据未跨越存储区尾部时长度为0
+	 */
+	array_range array_two() const {
+		size_t n = capacity_ - head_;
+		return array_range(buff_.get(), size_ > n ? size_ - n : 0);
+	}
+
+	/*!
+	 * @brief 查看自from开始长度为n的数据所在的连续存储区, 不拷贝数据
+	 * @param from 起始位置
+	 * @param n    长度. 调用者保证from + n <= size()
+	 * @param one  第一段
+	 * @param two  第二段. 数据未跨越存储区尾部时长度为0
+	 */
+	void range(size_t from, size_t n, array_range& one, array_range& two) const {
+		size_t pos = wrap(head_ + from);
+		size_t n1 = capacity_ - pos;
+		if (n1 > n) n1 = n;
+		one = array_range(buff_.get() + pos, n1);
+		two = array_range(buff_.get(), n - n1);
+	}
+
+	/*!
+	 * @brief 在尾部追加数据. 空间不足时覆盖最早的数据
+	 * @param data 数据
+	 * @param n    数据长度
+	 */
+	void push_back(const char* data, size_t n) {
+		if (!capacity_ || !n) return;
+		if (n >= capacity_) {// 仅保留最后capacity_字节
+			offset_ += size_ + n - capacity_;
+			memcpy(buff_.get(), data + n - capacity_, capacity_);
+			head_ = 0;
+			size_ = capacity_;
+			return;
+		}
+		if (n > reserve()) erase_begin(n - reserve());
+
+		size_t tail = wrap(head_ + size_);
+		size_t n1 = capacity_ - tail;
+		if (n1 > n) n1 = n;
+		memcpy(buff_.get() + tail, data, n1);
+		if (n > n1) memcpy(buff_.get(), data + n1, n - n1);
+		size_ += n;
+	}
+
+	/*!
+	 * @brief 从from开始拷贝数据, 不清除数据
+	 * @param data 输出存储区
+	 * @param n    期望长度
+	 * @param from 起始位置
+	 * @return
+	 * 实际拷贝长度
+	 */
+	size_t copy(char* data, size_t n, size_t from = 0) const {
+		if (from >= size_) return 0;
+		if (n > size_ - from) n = size_ - from;
+
+		size_t pos = wrap(head_ + from);
+		size_t n1 = capacity_ - pos;
+		if (n1 > n) n1 = n;
+		memcpy(data, buff_.get() + pos, n1);
+		if (n > n1) memcpy(data + n1, buff_.get(), n - n1);
+		return n;
+	}
+
+	/*!
+	 * @brief 清除前n个字节
+	 */
+	void erase_begin(size_t n) {
+		if (n >= size_) clear();
+		else {
+			head_ = wrap(head_ + n);
+			size_ -= n;
+			offset_ += n;
+		}
+	}
+
+	/*!
+	 * @brief 查找flag自from开始第一次出现的位置
+	 * @param flag 标识字符串
+	 * @param n    标识字符串长度
+	 * @param from 起始位置
+	 * @return
+	 * 标识串第一次出现位置. 若flag不存在则返回npos
+	 * @note
+	 * 若标识符与上次相同且from落在上次已检查区间内, 则跳过已确认不含标识符的数据
+	 */
+	size_t find(const char* flag, size_t n, size_t from = 0) {
+		if (!flag || !n || from >= size_ || n > size_ - from) return npos;
+
+		size_t from_abs = offset_ + from;
+		if (find_flag_.size() == n && !memcmp(find_flag_.data(), flag, n)
+				&& from_abs >= find_begin_ && from_abs <= find_next_) {
+			if ((from = find_next_ - offset_) > size_ - n) return npos;
+		}
+		else {
+			find_flag_.assign(flag, n);
+			find_begin_ = from_abs;
+		}
+
+		size_t pos = find_segments(flag, n, from);
+		if (pos != npos) find_next_ = offset_ + pos;
+		else find_next_ = offset_ + size_ - n + 1;
+		return pos;
+	}
+
+	/*!
+	 * @brief 在连续存储区中查找flag第一次出现的位置
+	 * @param data 存储区
+	 * @param len  存储区长度
+	 * @param flag 标识字符串
+	 * @param n    标识字符串长度
+	 * @return
+	 * 标识串第一次出现位置. 若flag不存在则返回npos
+	 */
+	static size_t search(const char* data, size_t len, const char* flag, size_t n) {
+		if (!n || n > len) return npos;
+		if (n == 1) {
+			const char* p = (const char*) memchr(data, flag[0], len);
+			return p ? size_t(p - data) : npos;
+		}
+
+		// Boyer-Moore-Horspool
+		size_t skip[256], i, last(n - 1);
+		const unsigned char* d = (const unsigned char*) data;
+		const unsigned char* f = (const unsigned char*) flag;
+		for (i = 0; i < 256; ++i) skip[i] = n;
+		for (i = 0; i < last; ++i) skip[f[i]] = last - i;
+		for (size_t pos = 0; pos <= len - n; pos += skip[d[pos + last]]) {
+			if (d[pos + last] == f[last] && !memcmp(d + pos, f, last))
+				return pos;
+		}
+		return npos;
+	}
+
+protected:
+	/*!
+	 * @brief 依次在第一段, 跨越尾部的衔接区和第二段中查找
+	 */
+	size_t find_segments(const char* flag, size_t n, size_t from) const {
+		array_range one = array_one();
+		array_range two = array_two();
+		size_t pos;
+
+		if (from < one.second) {
+			if ((pos = search(one.first + from, one.second - from, flag, n)) != npos)
+				return from + pos;
+			if (two.second && n > 1) {// 衔接区: 第一段末尾n-1字节与第二段开头n-1字节
+				size_t n1 = one.second - from < n - 1 ? one.second - from : n - 1;
+				size_t n2 = two.second < n - 1 ? two.second : n - 1;
+				std::string joint(one.first + one.second - n1, n1);
+				joint.append(two.first, n2);
+				if ((pos = search(joint.data(), joint.size(), flag, n)) != npos)
+					return one.second - n1 + pos;
+			}
+			from = 0;
+		}
+		else from -= one.second;
+
+		if ((pos = search(two.first + from, two.second - from, flag, n)) != npos)
+			return one.second + from + pos;
+		return npos;
+	}
+
+	size_t wrap(size_t pos) const {
+		return pos >= capacity_ ? pos - capacity_ : pos;
+	}
+};
+
+#endif /* SRC_BYTERING_H_ */
@@ -0,0 +1,81 @@
+/**
+ * @file Callback.h 单目标回调函数, 用于高频触发的场合替代boost::signals2::signal
+ * @version 0.1
+ * @date 2026-10-16
+ * @note
+ * - 接口与boost::signals2::signal的常用子集一致: connect, disconnect_all_slots, empty, operator()
+ * - 仅保存一个插槽. connect()替换已有插槽
+ * - 触发时仅一次acquire原子读取和一次间接调用, 不加锁, 不修改引用计数, 不遍历插槽链表
+ * - 插槽可在触发期间安全替换. 被替换的插槽可能仍在其它线程中执行, 延迟至析构时释放.
+ *   connect()用于建立连接时设置, 不宜在运行期间频繁调用
+ * - 需要多个插槽时仍使用boost::signals2::signal
+ */
+
+#ifndef SRC_CALLBACK_H_
+#define SRC_CALLBACK_H_
+
+#include <atomic>
+#include <vector>
+#include <boost/function.hpp>
+#include <boost/smart_ptr/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+template<typename Signature> class Callback;
+
+template<typename... Args>
+class Callback<void (Args...)> {
+public:
+	using slot_type = boost::function<void (Args...)>;	///< 插槽类型
+
+protected:
+	using SlotPtr = boost::shared_ptr<slot_type>;
+	std::atomic<const slot_type*> slot_;	///< 当前插槽. NULL: 未设置
+	std::vector<SlotPtr> slots_;	///< 已设置的全部插槽, 析构时释放
+	boost::mutex mtx_;		///< 互斥锁: slots_
+
+public:
+	Callback() {
+		slot_ = NULL;
+	}
+	Callback(const Callback&) = delete;
+	Callback& operator=(const Callback&) = delete;
+
+	/*!
+	 * @brief 设置插槽, 替换已有插槽
+	 * @param slot 插槽
+	 */
+	void connect(const slot_type& slot) {
+		if (slot.empty()) {
+			disconnect_all_slots();
+			return;
+		}
+		SlotPtr ptr(new slot_type(slot));
+		boost::mutex::scoped_lock lck(mtx_);
+		slots_.push_back(ptr);
+		slot_.store(ptr.get(), std::memory_order_release);
+	}
+
+	/*!
+	 * @brief 清除插槽
+	 */
+	void disconnect_all_slots() {
+		slot_.store(NULL, std::memory_order_release);
+	}
+
+	/*!
+	 * @brief 检查是否未设置插槽
+	 */
+	bool empty() const {
+		return !slot_.load(std::memory_order_acquire);
+	}
+
+	/*!
+	 * @brief 触发回调函数. 未设置插槽时无操作
+	 */
+	void operator()(Args... args) const {
+		const slot_type* slot = slot_.load(std::memory_order_acquire);
+		if (slot) (*slot)(args...);
+	}
+};
+
+#endif /* SRC_CALLBACK_H_ */
@@ -14,11 +14,11 @@
 #include <boost/smart_ptr/shared_ptr.hpp>
 #include <boost/smart_ptr/shared_array.hpp>
 #include <boost/thread.hpp>
-#include <boost/signals2.hpp>
 #include <string>
 #include <vector>
 #include "AstroDeviceDef.h"
 #include "ParamCamera.h"
+#include "Callback.h"
 
 using std::string;
 using std::vector;
@@ -35,7 +35,7 @@ public:
 	 * @param <2> 曝光进度, 百分比
 	 * @param <3> 工作状态
 	 */
-	using ExposeProcess = boost::signals2::signal<void (double, double, int)>;
+	using ExposeProcess = Callback<void (double, double, int)>;
 	using ExpProcSlot   = ExposeProcess::slot_type;
 
 public:
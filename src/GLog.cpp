@@ -4,13 +4,57 @@
 
 #include <sys/param.h>
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <unistd.h>
-#include <stdarg.h>
+#include <signal.h>
 #include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <chrono>
+#include <map>
 #include "GLog.h"
 
+#define GLOG_FAULT_MAX	8	// FlushOnFault()可登记的实例数量
+
+static std::atomic<GLog*> faultLogs[GLOG_FAULT_MAX];	// 异常终止前需写出的日志
+static std::atomic<int64_t> utcOffset(0);	// UTC与单调时钟之差, 量纲: 纳秒
+static std::atomic<int64_t> resyncAt(0);	// 下次对齐的单调时钟, 量纲: 纳秒
+
+/*!
+ * @brief 以系统时钟修正UTC与单调时钟之差
+ */
+static int64_t resync_utc(int64_t steady) {
+	using namespace std::chrono;
+	int64_t utc = duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
+	utcOffset.store(utc - steady, std::memory_order_relaxed);
+	resyncAt.store(steady + int64_t(GLOG_RESYNC_SEC) * 1000000000, std::memory_order_relaxed);
+	return utc;
+}
+
+/*!
+ * @brief 由单调时钟推算的当前UTC时刻, 量纲: 纳秒
+ */
+static int64_t utc_now_ns() {
+	using namespace std::chrono;
+	int64_t steady = duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+	static int64_t anchor = resync_utc(steady);	// 首次调用时对齐, 其它线程等待完成
+	(void) anchor;
+
+	int64_t next = resyncAt.load(std::memory_order_relaxed);
+	if (steady >= next && resyncAt.compare_exchange_strong(next, steady + int64_t(GLOG_RESYNC_SEC) * 1000000000,
+			std::memory_order_relaxed))
+		return resync_utc(steady);
+	return steady + utcOffset.load(std::memory_order_relaxed);
+}
+
 GLog::GLog(FILE *out) {
 	dayOld_    = 0;
+	precision_ = 0;
+	binary_    = false;
+	recording_ = false;
+	filebin_   = false;
+	indexSec_  = 0;
+	fileOff_   = 0;
 	if ((fd_ = out) == NULL) {
 		char cwd[MAXPATHLEN];
 		dirName_ = getcwd(cwd, MAXPATHLEN);
@@ -20,10 +64,23 @@ GLog::GLog(FILE *out) {
 		if (cLast != '/' && cLast != '\\')
 			dirName_ += '/';
 	}
+	async_    = false;
+	inflight_ = 0;
+	waiting_  = false;
+	draining_.clear();
+	stop_      = false;
+	flush_ms_  = GLOG_FLUSH_MS;
+	flush_req_ = flushed_ = 0;
 }
 
 GLog::GLog(const char* dirName, const char* fileNamePrefix) {
 	dayOld_    = 0;
+	precision_ = 0;
+	binary_    = false;
+	recording_ = false;
+	filebin_   = false;
+	indexSec_  = 0;
+	fileOff_   = 0;
 	fd_        = NULL;
 	if (dirName)
 		dirName_ = dirName;
@@ -40,99 +97,841 @@ GLog::GLog(const char* dirName, const char* fileNamePrefix) {
 
 	if (prefix_.empty())
 		prefix_ = "gLog_";
+	async_    = false;
+	inflight_ = 0;
+	waiting_  = false;
+	draining_.clear();
+	stop_      = false;
+	flush_ms_  = GLOG_FLUSH_MS;
+	flush_req_ = flushed_ = 0;
 }
 
 GLog::~GLog() {
+	report_suppressed();
+	StopAsync();
+	for (int i = 0; i < GLOG_FAULT_MAX; ++i) {
+		GLog* self = this;
+		faultLogs[i].compare_exchange_strong(self, NULL);
+	}
 	if (fd_ && fd_ != stdout && fd_ != stderr)
 		fclose(fd_);
 }
 
 void GLog::Write(const char *format, ...) {
 	if (format) {
+		va_list vl;
+		va_start(vl, format);
+		write(NULL, LOG_NORMAL, format, vl);
+		va_end(vl);
+	}
+}
+
+void GLog::Write(LOG_TYPE type, const char *format, ...) {
+	if (format) {
+		va_list vl;
+		va_start(vl, format);
+		write(NULL, type, format, vl);
+		va_end(vl);
+	}
+}
+
+void GLog::Write(const char *where, LOG_TYPE type, const char *format, ...) {
+	if (format) {
+		va_list vl;
+		va_start(vl, format);
+		write(where, type, format, vl);
+		va_end(vl);
+	}
+}
+
+void GLog::WriteLines(const char *where, LOG_TYPE type, const char *text) {
+	if (!text) return;
+	const LogStamp& stamp = stamp_now();
+	const char *end;
+	for (; *text; text = *end ? end + 1 : end) {
+		if (!(end = strchr(text, '\n'))) end = text + strlen(text);
+		if (end > text) emitf(stamp, where, type, "%.*s", int(end - text), text);
+	}
+}
+
+bool GLog::StartAsync(int flush_ms) {
+	mutex_lock lck(mtx_);
+	if (async_) return true;
+
+	if (!ring_) ring_.reset(new LineRing(GLOG_RING_SIZE));
+	flush_ms_ = flush_ms > 0 ? flush_ms : GLOG_FLUSH_MS;
+	stop_ = false;
+	thrd_write_ = std::thread(&GLog::thread_write, this);
+	async_ = true;
+	return true;
+}
+
+void GLog::StopAsync() {
+	{
+		mutex_lock lck(mtx_);
+		if (!async_) return;
+		async_ = false;
+	}
+	while (inflight_.load()) std::this_thread::yield();	// 等待已进入异步路径的调用完成
+	{
+		mutex_lock lck(mtx_wait_);
+		stop_ = true;
+		cv_wait_.notify_one();
+	}
+	thrd_write_.join();
+}
+
+void GLog::Flush() {
+	report_suppressed();
+	if (async_) {
+		mutex_lock lck(mtx_wait_);
+		long req = ++flush_req_;
+		cv_wait_.notify_one();
+		cv_flushed_.wait(lck, [this, req]() { return flushed_ >= req || stop_; });
+	}
+	else {
 		mutex_lock lck(mtx_);
-		std::tm utc;
+		if (fd_) fflush(fd_);
+	}
+}
+
+void GLog::FlushOnFault() {
+	GLog* empty;
+	int i;
+
+	for (i = 0; i < GLOG_FAULT_MAX; ++i) {
+		if (faultLogs[i].load() == this) return;
+	}
+	for (i = 0; i < GLOG_FAULT_MAX; ++i) {
+		empty = NULL;
+		if (faultLogs[i].compare_exchange_strong(empty, this)) break;
+	}
+
+	struct sigaction sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = &GLog::on_fault;
+	sa.sa_flags   = SA_RESETHAND;
+	sigemptyset(&sa.sa_mask);
+	int signos[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+	for (i = 0; i < int(sizeof(signos) / sizeof(int)); ++i) sigaction(signos[i], &sa, NULL);
+}
+
+void GLog::SetPrecision(int digits) {
+	precision_ = digits <= 0 ? 0 : (digits <= 3 ? 3 : 6);
+}
 
-		if (valid_file(utc)) {
-			va_list vl;
+void GLog::SetBinary(bool enable) {
+	binary_ = enable;
+}
+
+void GLog::SetRateLimit(double rate, int burst) {
+	limiter_.Set(rate, burst);
+}
+
+bool GLog::StartRecorder(const char *path, size_t bytes) {
+	mutex_lock lck(mtx_);
+	if (!recorder_.IsOpen() && !recorder_.Open(path, bytes)) return false;
+	recording_ = true;
+	return true;
+}
+
+void GLog::StopRecorder() {
+	recording_ = false;
+}
+
+void GLog::record(const LogStamp &stamp, int kind, int type, const struct iovec *parts, int n) {
+	recorder_.Append(int64_t(stamp.sec) * 1000000000 + stamp.nsec, kind, type, parts, n);
+}
 
-			fprintf (fd_, "%02d:%02d:%02d >> ", utc.tm_hour, utc.tm_min, utc.tm_sec);
-			va_start(vl, format);
-			vfprintf(fd_, format, vl);
-			va_end(vl);
-			fprintf(fd_, "\n");
-			fflush(fd_);
+void GLog::SetIndex(int bucketSec) {
+	mutex_lock lck(mtx_);
+	indexSec_ = bucketSec > 0 ? bucketSec : 0;
+	if (!bucketSec) index_.Close();
+	else if (fd_ && fd_ != stdout && fd_ != stderr && !filebin_ && !index_.IsOpen() && !filePath_.empty())
+		index_.Open(filePath_ + ".idx", bucketSec, fileOff_);
+}
+
+void GLog::SetArchive(bool compress, int keepDays, uint64_t maxBytes) {
+	if (fd_ == stdout || fd_ == stderr) return;
+	archiver_.Start(dirName_, prefix_, compress, keepDays, maxBytes);
+}
+
+const GLog::LogStamp& GLog::stamp_now() {
+	static thread_local LogStamp cache;
+	int64_t ns = utc_now_ns();
+	std::time_t sec = std::time_t(ns / 1000000000);
+
+	cache.nsec = long(ns % 1000000000);
+	if (sec != cache.sec) {// 秒变化: 重新生成时分秒
+		cache.sec = sec;
+		gmtime_r(&sec, &cache.utc);
+		int v[] = { cache.utc.tm_hour, cache.utc.tm_min, cache.utc.tm_sec };
+		for (int i = 0; i < 3; ++i) {
+			cache.hms[i * 3]     = char('0' + v[i] / 10);
+			cache.hms[i * 3 + 1] = char('0' + v[i] % 10);
+			if (i < 2) cache.hms[i * 3 + 2] = ':';
 		}
 	}
+	return cache;
 }
 
-void GLog::Write(LOG_TYPE type, const char *format, ...) {
-	if (format) {
-		mutex_lock lck(mtx_);
-		std::tm utc;
+void GLog::on_fault(int signo) {
+	for (int i = 0; i < GLOG_FAULT_MAX; ++i) {
+		GLog* log = faultLogs[i].load();
+		if (!log || !log->ring_) continue;
+		// 写入线程正在读出队列时, 等待其完成当前批次
+		for (int j = 0; j < 100 && log->draining_.test_and_set(); ++j) usleep(1000);
+		log->drain(true);
+		if (log->fd_) fflush(log->fd_);
+	}
+	raise(signo);	// SA_RESETHAND: 恢复缺省处理
+}
 
-		if (valid_file(utc)) {
-			va_list vl;
+void GLog::write(const char *where, LOG_TYPE type, const char *format, va_list vl) {
+	const LogStamp& stamp = stamp_now();
+	if (limiter_.Enabled() && !admit(format, where, type, stamp)) return;	// 被抑制: 不格式化
+	emit(stamp, where, type, format, vl);
+}
 
-			fprintf (fd_, "%02d:%02d:%02d >> ", utc.tm_hour, utc.tm_min, utc.tm_sec);
-			if (type >= LOG_MIN && type <= LOG_MAX)
-				fprintf (fd_, "%s", LOG_TYPE_STR[type]);
-			va_start(vl, format);
-			vfprintf(fd_, format, vl);
-			va_end(vl);
-			fprintf(fd_, "\n");
-			fflush(fd_);
+void GLog::emitf(const LogStamp &stamp, const char *where, LOG_TYPE type, const char *format, ...) {
+	va_list vl;
+	va_start(vl, format);
+	emit(stamp, where, type, format, vl);
+	va_end(vl);
+}
+
+bool GLog::admit(const void *key, const char *where, LOG_TYPE type, const LogStamp &stamp) {
+	uint32_t folded;
+	if (!limiter_.Admit(key, where, type, int64_t(stamp.sec) * 1000000000 + stamp.nsec, folded))
+		return false;
+	if (folded) emitf(stamp, where, type, "last message repeated %u times", folded);
+	return true;
+}
+
+void GLog::report_suppressed() {
+	if (!limiter_.Enabled()) return;
+	const LogStamp& stamp = stamp_now();
+	limiter_.Collect([this, &stamp](const char *where, int type, uint32_t n) {
+		emitf(stamp, where, LOG_TYPE(type), "last message repeated %u times", n);
+	});
+}
+
+void GLog::emit(const LogStamp &stamp, const char *where, LOG_TYPE type, const char *format, va_list vl) {
+
+	if (binary_.load(std::memory_order_relaxed)) {// 二进制模式: 文本记录
+		char rec[GLOG_LINE_MAX];
+		int room = GLOG_LINE_MAX - int(sizeof(GLogRecord));
+		int n = format_body(rec + sizeof(GLogRecord), room, where, type, format, vl);
+		write_record(stamp, GLR_TEXT, type, 0, rec, n < room ? n : room - 1);
+		return;
+	}
+
+	if (async_.load(std::memory_order_acquire)) {
+		inflight_.fetch_add(1);
+		if (async_.load(std::memory_order_acquire)) {
+			bool urgent = type == LOG_FAULT;
+			auto fill = [&](LogLine& line) {
+				va_list vc;
+				va_copy(vc, vl);
+				int n = format_line(line.text, GLOG_LINE_MAX - 1, stamp, where, type, format, vc);
+				va_end(vc);
+				if (n > GLOG_LINE_MAX - 2) n = GLOG_LINE_MAX - 2;
+				line.text[n] = '\n';
+				line.len = n + 1;
+				line.sec = stamp.sec;
+				line.bin = false;
+				line.tag[0] = 0;
+				if (where && indexSec_.load(std::memory_order_relaxed)) {
+					strncpy(line.tag, where, GLOG_TAG_MAX - 1);
+					line.tag[GLOG_TAG_MAX - 1] = 0;
+				}
+				if (recording_.load(std::memory_order_relaxed)) {
+					struct iovec part = { line.text, size_t(n) };
+					record(stamp, GLS_LINE, type, &part, 1);
+				}
+			};
+			while (!ring_->emplace(fill)) {// 队列已满: 唤醒写入线程后让出CPU
+				cv_wait_.notify_one();
+				std::this_thread::yield();
+			}
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (waiting_.load(std::memory_order_relaxed)
+					&& (urgent || ring_->size_approx() >= GLOG_RING_SIZE / 4)) {
+				mutex_lock lck(mtx_wait_);
+				if (urgent) ++flush_req_;
+				cv_wait_.notify_one();
+			}
+			inflight_.fetch_sub(1);
+			return;
 		}
+		inflight_.fetch_sub(1);
+	}
+
+	char buf[1024];
+	va_list vc;
+	va_copy(vc, vl);
+	int n = format_line(buf, sizeof(buf) - 1, stamp, where, type, format, vc);
+	va_end(vc);
+	if (recording_.load(std::memory_order_relaxed)) {
+		struct iovec part = { buf, size_t(n < int(sizeof(buf)) - 1 ? n : int(sizeof(buf)) - 1) };
+		record(stamp, GLS_LINE, type, &part, 1);
+	}
+	if (n < int(sizeof(buf)) - 1) {
+		buf[n] = '\n';
+		write_line(stamp, where, buf, n + 1);
+	}
+	else {// 长日志
+		std::string text(n + 1, '\0');
+		format_line(&text[0], n + 1, stamp, where, type, format, vl);
+		text[n] = '\n';
+		write_line(stamp, where, text.data(), n + 1);
 	}
 }
 
-void GLog::Write(const char *where, LOG_TYPE type, const char *format, ...) {
-	if (format) {
-		mutex_lock lck(mtx_);
-		std::tm utc;
+int GLog::format_line(char *buf, int size, const LogStamp &stamp, const char *where, LOG_TYPE type,
+		const char *format, va_list vl) {
+	char prefix[24];
+	int n(sizeof(stamp.hms)), digits = precision_.load(std::memory_order_relaxed);
+
+	memcpy(prefix, stamp.hms, n);
+	if (digits) {// 秒以下部分
+		long frac = stamp.nsec / (digits == 3 ? 1000000 : 1000);
+		prefix[n] = '.';
+		for (int i = digits; i > 0; --i, frac /= 10) prefix[n + i] = char('0' + frac % 10);
+		n += digits + 1;
+	}
+	memcpy(prefix + n, " >> ", 4);
+	n += 4;
+	if (size > 0) {
+		int m = n < size ? n : size - 1;
+		memcpy(buf, prefix, m);
+		buf[m] = '\0';
+	}
+	return n + format_body(buf + n, size > n ? size - n : 0, where, type, format, vl);
+}
 
-		if (valid_file(utc)) {
-			va_list vl;
+int GLog::format_body(char *buf, int size, const char *where, LOG_TYPE type,
+		const char *format, va_list vl) {
+	int n(0);
 
-			fprintf (fd_, "%02d:%02d:%02d >> ", utc.tm_hour, utc.tm_min, utc.tm_sec);
-			if (type >= LOG_MIN && type <= LOG_MAX)
-				fprintf (fd_, "%s", LOG_TYPE_STR[type]);
-			if (where) fprintf (fd_, "%s, ", where);
-			va_start(vl, format);
-			vfprintf(fd_, format, vl);
-			va_end(vl);
-			fprintf(fd_, "\n");
-			fflush(fd_);
+	if (size > 0) buf[0] = '\0';
+	if (type >= LOG_MIN && type <= LOG_MAX)
+		n += snprintf(buf + n, size > n ? size - n : 0, "%s", LOG_TYPE_STR[type]);
+	if (where)
+		n += snprintf(buf + n, size > n ? size - n : 0, "%s, ", where);
+	n += vsnprintf(buf + n, size > n ? size - n : 0, format, vl);
+	return n;
+}
+
+void GLog::write_record(const LogStamp &stamp, int kind, int type, uint32_t id, char *rec, int size) {
+	GLogRecord* head = (GLogRecord*) rec;
+	head->length = uint16_t(sizeof(GLogRecord) + size);
+	head->kind   = uint8_t(kind);
+	head->type   = uint8_t(type);
+	head->id     = id;
+	head->stamp  = int64_t(stamp.sec) * 1000000000 + stamp.nsec;
+	if (recording_.load(std::memory_order_relaxed)) {
+		if (kind == GLR_TEXT) {
+			struct iovec part = { rec + sizeof(GLogRecord), size_t(size) };
+			record(stamp, GLS_TEXT, type, &part, 1);
+		}
+		else if (const GLogFormat* fmt = GLogFormats::Get(id)) {// 记录中保存格式, 无需登记表即可还原
+			const char *where = fmt->where ? fmt->where : "";
+			struct iovec parts[3] = {
+				{ (void*) where, strlen(where) + 1 },
+				{ (void*) fmt->format, strlen(fmt->format) + 1 },
+				{ rec + sizeof(GLogRecord), size_t(size) }
+			};
+			record(stamp, GLS_ENTRY, fmt->type, parts, 3);
 		}
 	}
+
+	if (async_.load(std::memory_order_acquire)) {
+		inflight_.fetch_add(1);
+		if (async_.load(std::memory_order_acquire)) {
+			auto fill = [&](LogLine& line) {
+				memcpy(line.text, rec, head->length);
+				line.len = head->length;
+				line.sec = stamp.sec;
+				line.bin = true;
+			};
+			while (!ring_->emplace(fill)) {
+				cv_wait_.notify_one();
+				std::this_thread::yield();
+			}
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (waiting_.load(std::memory_order_relaxed) && ring_->size_approx() >= GLOG_RING_SIZE / 4) {
+				mutex_lock lck(mtx_wait_);
+				cv_wait_.notify_one();
+			}
+			inflight_.fetch_sub(1);
+			return;
+		}
+		inflight_.fetch_sub(1);
+	}
+
+	mutex_lock lck(mtx_);
+	put_record(stamp.utc, rec, head->length);
+	if (fd_) fflush(fd_);
 }
 
-bool GLog::valid_file(std::tm &utc) {
-	std::time_t now = std::time(nullptr);
-	memcpy(&utc, std::gmtime(&now), sizeof(std::tm));
+void GLog::put_record(const std::tm &utc, const char *rec, int len) {
+	const GLogRecord* head = (const GLogRecord*) rec;
 
-	if (fd_ == stdout || fd_ == stderr)
-		return true;
+	if (!valid_file(utc, true)) return;
+	if (head->kind == GLR_ENTRY) {
+		const GLogFormat* fmt = GLogFormats::Get(head->id);
+		if (!fmt) return;
+		if (head->id >= defined_.size()) defined_.resize(head->id + 1, 0);
+		if (!defined_[head->id]) {// 首次出现在当前文件: 写出格式定义
+			const char* where = fmt->where ? fmt->where : "";
+			size_t n1 = strlen(where) + 1, n2 = strlen(fmt->format) + 1;
+			GLogRecord def;
+			if (sizeof(def) + n1 + n2 > 0xFFFF) return;
+			def.length = uint16_t(sizeof(def) + n1 + n2);
+			def.kind   = GLR_FORMAT;
+			def.type   = uint8_t(fmt->type);
+			def.id     = head->id;
+			def.stamp  = 0;
+			fwrite(&def, sizeof(def), 1, fd_);
+			fwrite(where, 1, n1, fd_);
+			fwrite(fmt->format, 1, n2, fd_);
+			defined_[head->id] = 1;
+		}
+	}
+	fwrite(rec, 1, len, fd_);
+}
+
+/*!
+ * @brief 依据格式字符串和已编码的参数生成文本
+ * @param format  格式字符串
+ * @param args    参数序列
+ * @param size    参数序列长度
+ */
+static std::string render_args(const char *format, const char *args, int size) {
+	std::string text, spec;
+	char buf[512];
+	int pos(0);
+
+	// 读出下一个参数. 参数缺失时返回0
+	auto next = [&](int64_t &iv, double &fv, std::string &sv) -> char {
+		if (pos >= size) return 0;
+		char tag = args[pos++];
+		if (tag == GLA_STR) {
+			uint16_t n(0);
+			if (pos + 2 <= size) memcpy(&n, args + pos, 2);
+			pos += 2;
+			if (pos + n > size) n = uint16_t(size > pos ? size - pos : 0);
+			sv.assign(args + pos, n);
+			pos += n;
+		}
+		else if (pos + 8 <= size) {
+			if (tag == GLA_DOUBLE) {
+				memcpy(&fv, args + pos, 8);
+				iv = int64_t(fv);
+			}
+			else {
+				memcpy(&iv, args + pos, 8);
+				fv = tag == GLA_UINT ? double(uint64_t(iv)) : double(iv);
+			}
+			pos += 8;
+		}
+		else pos = size;
+		return tag;
+	};
 
-	if (dayOld_ != utc.tm_mday) {
-		dayOld_ = utc.tm_mday;
-		if (fd_) {// 关闭已打开的日志文件
-			fprintf(fd_, "%s continue\n", std::string(69, '>').c_str());
-			fclose(fd_);
-			fd_ = NULL;
+	for (const char *p = format; *p; ++p) {
+		if (*p != '%') {
+			text += *p;
+			continue;
 		}
+		if (p[1] == '%') {
+			text += '%';
+			++p;
+			continue;
+		}
+
+		int64_t iv(0);
+		double fv(0.0);
+		std::string sv;
+		spec = "%";
+		for (++p; *p && strchr("-+ #0'", *p); ++p) spec += *p;	// 标志
+		for (; *p && (isdigit(*p) || *p == '*' || *p == '.'); ++p) {// 宽度与精度
+			if (*p == '*') {
+				next(iv, fv, sv);
+				spec += std::to_string(iv);
+			}
+			else spec += *p;
+		}
+		while (*p && strchr("hlLqjzt", *p)) ++p;	// 忽略长度修饰符, 按编码类型输出
+		if (!*p) break;
+
+		char conv = *p;
+		char tag  = next(iv, fv, sv);
+		int n(0);
+		if (strchr("diouxXc", conv)) {
+			spec += conv == 'c' ? "c" : "ll";
+			if (conv != 'c') spec += conv;
+			n = conv == 'c' ? snprintf(buf, sizeof(buf), spec.c_str(), int(iv))
+					: snprintf(buf, sizeof(buf), spec.c_str(), (long long) iv);
+		}
+		else if (strchr("eEfFgGaA", conv)) {
+			spec += conv;
+			n = snprintf(buf, sizeof(buf), spec.c_str(), fv);
+		}
+		else if (conv == 's') {
+			spec += 's';
+			if (tag != GLA_STR) sv = tag ? std::to_string(iv) : "(null)";
+			if (spec == "%s") {
+				text += sv;
+				continue;
+			}
+			n = snprintf(buf, sizeof(buf), spec.c_str(), sv.c_str());
+		}
+		else if (conv == 'p') {
+			n = snprintf(buf, sizeof(buf), "%p", (void*) uintptr_t(iv));
+		}
+		if (n > 0) text.append(buf, n < int(sizeof(buf)) ? n : int(sizeof(buf)) - 1);
 	}
+	return text;
+}
+
+/*!
+ * @brief 输出时标"HH:MM:SS[.fff] >> "
+ * @param stamp   UTC时刻, 量纲: 纳秒
+ * @param digits  秒以下的位数: 0, 3或6
+ */
+static void put_stamp(FILE *out, int64_t stamp, int digits) {
+	char prefix[40];
+	std::time_t sec = std::time_t(stamp / 1000000000);
+	long nsec = long(stamp % 1000000000);
+	std::tm utc;
+
+	gmtime_r(&sec, &utc);
+	int m = snprintf(prefix, sizeof(prefix), "%02d:%02d:%02d", utc.tm_hour, utc.tm_min, utc.tm_sec);
+	if (digits) m += snprintf(prefix + m, sizeof(prefix) - m, ".%0*ld", digits, nsec / (digits == 3 ? 1000000 : 1000));
+	fprintf(out, "%s >> ", prefix);
+}
+
+/*!
+ * @brief 输出二进制日志的类型、位置和内容
+ */
+static void put_entry(FILE *out, int type, const char *where, const char *format, const char *args, int size) {
+	if (type >= LOG_MIN && type <= LOG_MAX) fputs(LOG_TYPE_STR[type], out);
+	if (where && *where) fprintf(out, "%s, ", where);
+	std::string text = render_args(format, args, size);
+	fwrite(text.data(), 1, text.size(), out);
+}
+
+int GLog::Decode(const char *path, FILE *out, int digits) {
+	struct Format {
+		int type;
+		std::string where, format;
+	};
+	std::map<uint32_t, Format> formats;
+	std::vector<char> data;
+	gzFile fp = gzopen(path, "rb");	// 兼容已压缩的文件
+	char head[sizeof(GLOG_BIN_MAGIC)];
+	int lines(0), got;
+
+	if (!fp) return -1;
+	if (gzread(fp, head, sizeof(head)) != int(sizeof(head)) || memcmp(head, GLOG_BIN_MAGIC, sizeof(head))) {
+		gzclose(fp);
+		return -1;
+	}
+	do {
+		size_t size = data.size();
+		data.resize(size + 65536);
+		got = gzread(fp, data.data() + size, 65536);
+		data.resize(size + (got > 0 ? got : 0));
+	} while (got > 0);
+	gzclose(fp);
+
+	digits = digits <= 0 ? 0 : (digits <= 3 ? 3 : 6);
+	for (size_t pos = 0; pos + sizeof(GLogRecord) <= data.size(); ) {
+		GLogRecord rec;
+		memcpy(&rec, data.data() + pos, sizeof(rec));
+		if (rec.length < sizeof(rec) || pos + rec.length > data.size()) break;	// 记录不完整
+		const char *body = data.data() + pos + sizeof(rec);
+		int n = int(rec.length - sizeof(rec));
+		pos += rec.length;
+
+		if (rec.kind == GLR_FORMAT) {
+			Format& fmt = formats[rec.id];
+			fmt.type   = rec.type;
+			int n1 = int(strnlen(body, n));
+			fmt.where  = std::string(body, n1);
+			fmt.format = n1 < n ? std::string(body + n1 + 1, strnlen(body + n1 + 1, n - n1 - 1)) : "";
+			continue;
+		}
+
+		put_stamp(out, rec.stamp, digits);
+		if (rec.kind == GLR_TEXT) fwrite(body, 1, n, out);
+		else if (rec.kind == GLR_ENTRY) {
+			std::map<uint32_t, Format>::iterator it = formats.find(rec.id);
+			if (it == formats.end()) fprintf(out, "<unknown format %u>", rec.id);
+			else {
+				Format& fmt = it->second;
+				put_entry(out, fmt.type, fmt.where.c_str(), fmt.format.c_str(), body, n);
+			}
+		}
+		fputc('\n', out);
+		++lines;
+	}
+	return lines;
+}
+
+int GLog::ExtractRecorder(const char *path, FILE *out, int digits) {
+	GLogRecorderReader reader;
+	std::vector<const GLogSlot*> slots;
+
+	if (!reader.Open(path)) return -1;
+	reader.Collect(slots);
+	digits = digits <= 0 ? 0 : (digits <= 3 ? 3 : 6);
+	for (size_t i = 0; i < slots.size(); ++i) {
+		const GLogSlot* slot = slots[i];
+		const char *body = slot->payload();
+		int n = slot->len;
+
+		if (slot->kind != GLS_LINE) put_stamp(out, slot->stamp, digits);
+		if (slot->kind == GLS_ENTRY) {// 位置\0格式\0参数
+			int n1 = int(strnlen(body, n));
+			int n2 = n1 < n ? int(strnlen(body + n1 + 1, n - n1 - 1)) : 0;
+			int skip = std::min(n, n1 + n2 + 2);
+			std::string where(body, n1), format(body + std::min(n, n1 + 1), n2);
+			put_entry(out, slot->type, where.c_str(), format.c_str(), body + skip, n - skip);
+		}
+		else fwrite(body, 1, n, out);
+		fputc('\n', out);
+	}
+	return int(slots.size());
+}
+
+/*!
+ * @brief 由日志文件名中的日期得到当日0时的UTC秒
+ * @return
+ * 文件名不含"YYYYMMDD.log"时返回-1
+ */
+static std::time_t file_day(const char *path) {
+	const char *base = strrchr(path, '/');
+	const char *dot  = strstr(base = base ? base + 1 : path, ".log");
+	int date(0);
+
+	if (!dot || dot - base < 8) return -1;
+	for (const char *p = dot - 8; p < dot; ++p) {
+		if (!isdigit(*p)) return -1;
+		date = date * 10 + (*p - '0');
+	}
+	std::tm tm;
+	memset(&tm, 0, sizeof(tm));
+	tm.tm_year = date / 10000 - 1900;
+	tm.tm_mon  = date / 100 % 100 - 1;
+	tm.tm_mday = date % 100;
+	return timegm(&tm);
+}
+
+/*!
+ * @brief 检查文本日志行的位置标签
+ */
+static bool match_where(const char *line, const char *where) {
+	const char *p = strstr(line, " >> ");
+	if (!p) return false;
+	p += 4;
+	for (int t = LOG_MIN; t <= LOG_MAX; ++t) {
+		size_t n = strlen(LOG_TYPE_STR[t]);
+		if (!strncmp(p, LOG_TYPE_STR[t], n)) {
+			p += n;
+			break;
+		}
+	}
+	size_t n = strlen(where);
+	return !strncmp(p, where, n) && p[n] == ',' && p[n + 1] == ' ';
+}
+
+int GLog::Query(const char *path, FILE *out, std::time_t from, std::time_t to, const char *where) {
+	typedef std::pair<uint64_t, uint64_t> Range;	// 读取区间[first, second)
+	const uint64_t eof = uint64_t(-1);
+	std::vector<Range> ranges;
+	gzFile fp = gzopen(path, "rb");	// 兼容已压缩的文件
+	if (!fp) return -1;
+
+	// 由索引确定需读取的分桶. 无索引时读取全部
+	std::string base(path);
+	if (base.size() > 3 && !base.compare(base.size() - 3, 3, ".gz")) base.resize(base.size() - 3);
+	GLogIndexReader index;
+	if (!index.Load((base + ".idx").c_str()) && !index.Load((base + ".idx.gz").c_str()))
+		ranges.push_back(Range(0, eof));
+	else {
+		std::vector<uint64_t> tagged;
+		if (where) {
+			std::map<std::string, std::vector<uint64_t> >::iterator it = index.tags.find(where);
+			if (it != index.tags.end()) tagged = it->second;
+			std::sort(tagged.begin(), tagged.end());
+		}
+		for (size_t i = 0; i < index.buckets.size(); ++i) {
+			const GLogIndexReader::Bucket& bucket = index.buckets[i];
+			if ((from && bucket.start + bucket.width <= from) || (to && bucket.start >= to)) continue;
+			if (where && !std::binary_search(tagged.begin(), tagged.end(), bucket.offset)) continue;
+			uint64_t end = i + 1 < index.buckets.size() ? index.buckets[i + 1].offset : eof;
+			if (!ranges.empty() && ranges.back().second == bucket.offset) ranges.back().second = end;
+			else ranges.push_back(Range(bucket.offset, end));
+		}
+	}
+
+	std::time_t day = file_day(path);
+	std::string line;
+	char buf[4096];
+	int lines(0);
+	bool keep(false);	// 无时标的续行沿用上一行的结果
+
+	// 已压缩且索引记录了gzip成员的文件: 从区间所在成员的起点解压
+	bool members = !index.members.empty() && !index.members[0].offset && base.size() < strlen(path);
+	for (size_t i = 0; i < ranges.size(); ++i) {
+		gzFile in = fp;
+		uint64_t skip = ranges[i].first;
+		if (members) {
+			GLogIndexMember key = { ranges[i].first, 0 };
+			const GLogIndexMember& member = *(std::upper_bound(index.members.begin(), index.members.end(), key,
+					[](const GLogIndexMember& a, const GLogIndexMember& b) { return a.offset < b.offset; }) - 1);
+			int fd = open(path, O_RDONLY);
+			if (fd < 0 || lseek(fd, off_t(member.zoffset), SEEK_SET) < 0 || !(in = gzdopen(fd, "rb"))) {
+				if (fd >= 0) close(fd);
+				break;
+			}
+			skip -= member.offset;
+		}
+		if (gzseek(in, z_off_t(skip), SEEK_SET) < 0) {
+			if (in != fp) gzclose(in);
+			break;
+		}
+		uint64_t pos = ranges[i].first;
+		while (pos < ranges[i].second && gzgets(in, buf, sizeof(buf))) {
+			line.assign(buf);
+			while (line.back() != '\n' && gzgets(in, buf, sizeof(buf))) line += buf;	// 长行
+			pos += line.size();
+			if (!line.compare(0, 5, "-----") || !line.compare(0, 5, ">>>>>")) continue;	// 文件分隔标记
+
+			if (line.size() > 8 && line[2] == ':' && line[5] == ':') {
+				std::time_t t = day + atoi(line.c_str()) * 3600 + atoi(line.c_str() + 3) * 60 + atoi(line.c_str() + 6);
+				keep = (day < 0 || ((!from || t >= from) && (!to || t < to)))
+						&& (!where || match_where(line.c_str(), where));
+			}
+			if (keep) {
+				fputs(line.c_str(), out);
+				++lines;
+			}
+		}
+		if (in != fp) gzclose(in);
+	}
+	gzclose(fp);
+	return lines;
+}
+
+void GLog::write_line(const LogStamp &stamp, const char *where, const char *text, int len) {
+	mutex_lock lck(mtx_);
+	if (valid_file(stamp.utc)) {
+		put_line(stamp.sec, where, text, len);
+		fflush(fd_);
+		if (index_.IsOpen()) index_.Flush();
+	}
+}
+
+void GLog::put_line(std::time_t sec, const char *where, const char *text, int len) {
+	if (index_.IsOpen()) index_.Line(sec, where, fileOff_);
+	fwrite(text, 1, len, fd_);
+	fileOff_ += len;
+}
+
+void GLog::thread_write() {
+	long req;
+	bool stop;
+
+	do {
+		{
+			mutex_lock lck(mtx_wait_);
+			waiting_.store(true, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (!stop_ && flush_req_ == flushed_ && ring_->size_approx() < GLOG_RING_SIZE / 4)
+				cv_wait_.wait_for(lck, std::chrono::milliseconds(flush_ms_));
+			waiting_.store(false, std::memory_order_relaxed);
+			req  = flush_req_;
+			stop = stop_;
+		}
+
+		while (draining_.test_and_set(std::memory_order_acquire)) std::this_thread::yield();
+		int n = drain();
+		draining_.clear(std::memory_order_release);
+		if (n) {
+			mutex_lock lck(mtx_);
+			if (fd_) fflush(fd_);
+			if (index_.IsOpen()) index_.Flush();
+		}
+
+		{
+			mutex_lock lck(mtx_wait_);
+			flushed_ = req;
+			cv_flushed_.notify_all();
+		}
+	} while (!stop);
+}
+
+int GLog::drain(bool fault) {
+	LogLine line;
+	int n(0);
+	std::time_t sec(-1);
+	std::tm utc;
+	mutex_lock lck(mtx_, std::defer_lock);
+
+	if (fault) lck.try_lock();	// 持有互斥锁的线程可能已经崩溃
+	while (ring_->pop(line)) {
+		if (!fault && !lck.owns_lock()) lck.lock();
+		if (line.sec != sec) gmtime_r(&(sec = line.sec), &utc);
+		if (line.bin) put_record(utc, line.text, line.len);
+		else if (valid_file(utc)) put_line(line.sec, line.tag, line.text, line.len);
+		++n;
+	}
+	return n;
+}
+
+bool GLog::valid_file(const std::tm &utc, bool bin) {
+	if (fd_ == stdout || fd_ == stderr)
+		return true;
+	// 时标在互斥锁之外取得, 跨日时早于当前文件日期的日志可能晚到. 仅向后轮换, 晚到的日志写入当前文件
+	int date = (utc.tm_year + 1900) * 10000 + (utc.tm_mon + 1) * 100 + utc.tm_mday;
+	if (fd_ && date <= dayOld_ && filebin_ == bin)
+		return true;
+	if (fd_ && date < dayOld_) date = dayOld_;	// 切换文本/二进制格式: 沿用当前日期
+
+	// 先打开新文件, 再移交旧文件
+	FILE *old = fd_, *oldidx = index_.Detach();
+	bool mark = fd_ && !filebin_ && dayOld_ != date;	// 跨日的文本日志写入续接标记
 
-	if (!fd_) {
-		if (access(dirName_.c_str(), F_OK)) mkdir(dirName_.c_str(), 0755);	// 创建目录
-		if (!access(dirName_.c_str(), W_OK | X_OK)) {
-			char filepath[MAXPATHLEN];
-			sprintf (filepath, "%s%s%d%02d%02d.log",
-					dirName_.c_str(), prefix_.c_str(),
-					utc.tm_year + 1900, utc.tm_mon + 1, utc.tm_mday);
-			printf ("log path: %s\n", filepath);
-			fd_ = fopen(filepath, "a+");
-			fprintf(fd_, "%s\n", std::string(79, '-').c_str());
+	fd_ = NULL;
+	dayOld_ = date;
+	if (access(dirName_.c_str(), F_OK)) mkdir(dirName_.c_str(), 0755);	// 创建目录
+	if (!access(dirName_.c_str(), W_OK | X_OK)) {
+		char filepath[MAXPATHLEN];
+		sprintf (filepath, "%s%s%08d.%s", dirName_.c_str(), prefix_.c_str(), date, bin ? "blog" : "log");
+		printf ("log path: %s\n", filepath);
+		if ((fd_ = fopen(filepath, "a+")) != NULL) {
+			filebin_  = bin;
+			filePath_ = filepath;
+			if (!bin) {
+				fprintf(fd_, "%s\n", std::string(79, '-').c_str());
+				fseek(fd_, 0, SEEK_END);
+				fileOff_ = uint64_t(ftell(fd_));
+				int bucketSec = indexSec_.load();
+				if (bucketSec) index_.Open(std::string(filepath) + ".idx", bucketSec, fileOff_);
+			}
+			else {
+				defined_.clear();
+				fseek(fd_, 0, SEEK_END);
+				if (!ftell(fd_)) fwrite(GLOG_BIN_MAGIC, 1, sizeof(GLOG_BIN_MAGIC), fd_);
+			}
 		}
 	}
+	if (oldidx) archiver_.Retire(oldidx, false, date);
+	if (old) archiver_.Retire(old, mark, date);
+	else if (fd_) archiver_.SetCurrent(date);
 	return fd_ != NULL;
 }
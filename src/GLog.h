@@ -11,15 +11,54 @@
  * @version      2.2
  * @date         2020年9月30日
  * - 使用标准c/c++库替代boost库
+ * @version      2.3
+ * @date         2026年10月16日
+ * - 可选异步模式: 调用线程在预分配的无锁环形队列中格式化日志, 后台线程批量写入文件,
+ *   按时间间隔或积压数量刷新. 错误日志、Flush()、StopAsync()及析构时立即刷新
+ * - FlushOnFault(): 进程因信号异常终止前写出队列中的日志
+ * - 时标缓存: 各线程仅在秒变化时重新生成"HH:MM:SS", 不再逐行调用gmtime
+ * - SetPrecision(): 可选毫秒或微秒时标. 时标由单调时钟推算, 定时与系统UTC时钟对齐
+ * - 二进制模式: GLOG_BIN()登记调用点的格式字符串, 日志仅记录格式编号、时标和参数原始字节,
+ *   写入扩展名为.blog的文件. Decode()将其还原为文本格式. 此模式下普通Write()记录为文本记录,
+ *   长度不超过GLOG_LINE_MAX
+ * - SetRateLimit(): 按调用点(格式字符串)限流. 被抑制的日志不格式化, 其数量在该调用点下一条
+ *   日志之前或Flush()时以"last message repeated N times"记录
+ * - 日志级别: GLOG_TRACE()等宏在编译期滤除低于GLOG_MIN_LEVEL的日志, 运行期按模块阈值过滤.
+ *   过滤发生在参数求值之前
+ * - 轮换日志文件时先打开新文件, 旧文件交由归档线程关闭. SetArchive()启用后台压缩与按时间、
+ *   总量清理
+ * - 飞行记录器: StartRecorder()将最近的日志同时写入内存映射的环形文件, 进程崩溃后以
+ *   ExtractRecorder()读出
+ * - 索引: SetIndex()为文本日志文件写入".idx"索引(时间分桶与位置标签到偏移量), Query()按时间
+ *   范围和位置标签直接定位. 归档压缩的日志按分桶分段为多个gzip成员, 查询时仍只解压相关成员
  */
 
 #ifndef SRC_GLOG_H_
 #define SRC_GLOG_H_
 
 #include <stdio.h>
+#include <stdarg.h>
 #include <string>
 #include <ctime>
 #include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <vector>
+#include "MPSCQueue.h"
+#include "GLogBinary.h"
+#include "GLogLimiter.h"
+#include "GLogLevel.h"
+#include "GLogArchive.h"
+#include "GLogRecorder.h"
+#include "GLogIndex.h"
+
+#define GLOG_LINE_MAX	512		///< 异步模式单行日志最大长度, 超出部分被截断
+#define GLOG_RING_SIZE	4096	///< 异步模式环形队列容量, 量纲: 行
+#define GLOG_FLUSH_MS	200		///< 异步模式缺省刷新间隔, 量纲: 毫秒
+#define GLOG_RESYNC_SEC	60		///< 单调时钟与UTC的对齐周期, 量纲: 秒
+#define GLOG_TAG_MAX	32		///< 异步模式下为索引保存的位置标签最大长度
 
 enum LOG_TYPE {// 日志类型
 	LOG_NORMAL,		/// 普通
@@ -57,6 +96,155 @@ public:
 	void Write(const char *format, ...);
 	void Write(LOG_TYPE type, const char *format, ...);
 	void Write(const char *where, LOG_TYPE type, const char *format, ...);
+	/*!
+	 * @brief 记录多行文本, 每行一条日志, 时标相同. 不受限流约束
+	 * @param where   日志发生位置
+	 * @param type    日志类型
+	 * @param text    文本, 以换行符分隔各行. 空行被忽略
+	 * @note
+	 * 适用于周期性输出的报表, 例如消息队列统计
+	 */
+	void WriteLines(const char *where, LOG_TYPE type, const char *text);
+	/*!
+	 * @brief 启用异步模式
+	 * @param flush_ms 刷新间隔, 量纲: 毫秒
+	 * @return
+	 * 操作结果. 已启用时返回true
+	 */
+	bool StartAsync(int flush_ms = GLOG_FLUSH_MS);
+	/*!
+	 * @brief 停止异步模式. 写出队列中的全部日志后返回
+	 */
+	void StopAsync();
+	/*!
+	 * @brief 写出已记录的日志并刷新文件. 异步模式下等待后台线程完成
+	 */
+	void Flush();
+	/*!
+	 * @brief 进程收到SIGSEGV/SIGBUS/SIGFPE/SIGILL/SIGABRT时写出异步队列中的日志
+	 * @note
+	 * 尽力而为: 信号处理函数中调用的文件操作并非全部是异步信号安全的
+	 */
+	void FlushOnFault();
+	/*!
+	 * @brief 设置时标中秒以下的位数
+	 * @param digits 0: 秒; 3: 毫秒; 6: 微秒. 其它值取不小于它的最近一档
+	 */
+	void SetPrecision(int digits);
+	/*!
+	 * @brief 启用或停止二进制模式. 日志文件在下一条日志时切换
+	 */
+	void SetBinary(bool enable);
+	/*!
+	 * @brief 设置按调用点的限流参数
+	 * @param rate   每个调用点每秒允许的日志数量. <= 0: 不限流
+	 * @param burst  允许的突发数量
+	 */
+	void SetRateLimit(double rate, int burst = 10);
+	/*!
+	 * @brief 启用日志归档. 由低优先级线程压缩已轮换的文件并清理
+	 * @param compress  以gzip格式压缩早于当日的日志文件
+	 * @param keepDays  保留天数. 0: 不限
+	 * @param maxBytes  日志目录中本前缀文件的总量上限, 量纲: 字节. 0: 不限
+	 * @note
+	 * 仅适用于写入日志目录的GLog对象
+	 */
+	void SetArchive(bool compress, int keepDays = 0, uint64_t maxBytes = 0);
+	/*!
+	 * @brief 启用飞行记录器. 日志同时写入内存映射的环形文件, 无锁
+	 * @param path   记录文件路径. 已存在的文件改名为"path.prev"
+	 * @param bytes  记录文件容量, 量纲: 字节
+	 * @return
+	 * 操作结果. 已启用时返回true, 不更改文件
+	 */
+	bool StartRecorder(const char *path, size_t bytes = GLOG_REC_SIZE);
+	/*!
+	 * @brief 暂停飞行记录器. 记录文件在析构时关闭
+	 */
+	void StopRecorder();
+	/*!
+	 * @brief 读出飞行记录文件中的日志
+	 * @param path    记录文件路径
+	 * @param out     输出文件
+	 * @param digits  时标中秒以下的位数: 0, 3或6
+	 * @return
+	 * 读出的日志行数. 文件不存在或格式错误时返回-1
+	 */
+	static int ExtractRecorder(const char *path, FILE *out, int digits = 0);
+	/*!
+	 * @brief 为文本日志文件写入索引
+	 * @param bucketSec 时间分桶宽度, 量纲: 秒. 0: 停止
+	 */
+	void SetIndex(int bucketSec = GLOG_IDX_BUCKET);
+	/*!
+	 * @brief 按时间范围和位置标签查询文本日志
+	 * @param path   日志文件路径. 可为gzip压缩文件. 存在索引文件时仅读取相关分桶
+	 * @param out    输出文件
+	 * @param from   起始UTC时刻, 含. 0: 不限
+	 * @param to     结束UTC时刻, 不含. 0: 不限
+	 * @param where  位置标签. NULL: 不限
+	 * @return
+	 * 输出的日志行数. 文件不存在时返回-1
+	 */
+	static int Query(const char *path, FILE *out, std::time_t from, std::time_t to, const char *where = NULL);
+	/*!
+	 * @brief 登记格式. 通常由GLOG_BIN()在每个调用点调用一次
+	 * @param where   日志发生位置. 须为静态存储期的字符串或NULL
+	 * @param type    日志类型
+	 * @param format  日志格式. 须为静态存储期的字符串
+	 * @return
+	 * 格式编号
+	 */
+	static uint32_t RegisterFormat(const char *where, LOG_TYPE type, const char *format) {
+		return GLogFormats::Register(where, type, format);
+	}
+	/*!
+	 * @brief 以已登记的格式记录日志
+	 * @param id    格式编号
+	 * @param args  参数. 支持整数、枚举、浮点数、C字符串、std::string和指针
+	 * @note
+	 * 二进制模式下仅编码参数, 否则按格式即时生成文本日志
+	 */
+	template<typename... Args>
+	void WriteBin(uint32_t id, const Args&... args) {
+		if (!binary_.load(std::memory_order_relaxed)) {
+			const GLogFormat* fmt = GLogFormats::Get(id);
+			if (fmt) Write(fmt->where, LOG_TYPE(fmt->type), fmt->format, glog_arg(args)...);
+			return;
+		}
+		char rec[GLOG_LINE_MAX];
+		const LogStamp& stamp = stamp_now();
+		if (limiter_.Enabled()) {
+			const GLogFormat* fmt = GLogFormats::Get(id);
+			if (fmt && !admit(fmt->format, fmt->where, LOG_TYPE(fmt->type), stamp)) return;
+		}
+		GLogEncoder enc(rec + sizeof(GLogRecord), GLOG_LINE_MAX - int(sizeof(GLogRecord)));
+		enc.Args(args...);
+		write_record(stamp, GLR_ENTRY, 0, id, rec, enc.Size());
+	}
+	/*!
+	 * @brief 将二进制日志还原为文本
+	 * @param path    二进制日志文件路径. 可为gzip压缩文件
+	 * @param out     输出文件
+	 * @param digits  时标中秒以下的位数: 0, 3或6
+	 * @return
+	 * 还原的日志行数. 文件不存在或格式错误时返回-1
+	 */
+	static int Decode(const char *path, FILE *out, int digits = 0);
+
+protected:
+	struct LogStamp {// 时标. 各线程独立缓存
+		std::time_t sec;	//< UTC秒
+		long nsec;			//< 秒以下部分, 量纲: 纳秒
+		std::tm utc;		//< 秒对应的UTC时间
+		char hms[8];		//< "HH:MM:SS", 不含结束符
+
+	public:
+		LogStamp() : utc(), hms() {
+			sec  = -1;
+			nsec = 0;
+		}
+	};
 
 protected:
 	/*!
@@ -64,18 +252,163 @@ protected:
 	 * @return
 	 * 检查并创建日志文件
 	 */
-	bool valid_file(std::tm &utc);
+	bool valid_file(const std::tm &utc, bool bin = false);
+	/*!
+	 * @brief 当前时刻
+	 * @return
+	 * 调用线程的时标缓存. 秒变化时更新utc和hms
+	 */
+	static const LogStamp& stamp_now();
+	/*!
+	 * @brief 限流检查后格式化日志
+	 */
+	void write(const char *where, LOG_TYPE type, const char *format, va_list vl);
+	/*!
+	 * @brief 格式化日志并写入文件或异步队列
+	 */
+	void emit(const LogStamp &stamp, const char *where, LOG_TYPE type, const char *format, va_list vl);
+	void emitf(const LogStamp &stamp, const char *where, LOG_TYPE type, const char *format, ...);
+	/*!
+	 * @brief 限流检查
+	 * @param key 调用点
+	 * @return
+	 * 允许记录时返回true. 此前有被抑制的日志时先记录其数量
+	 */
+	bool admit(const void *key, const char *where, LOG_TYPE type, const LogStamp &stamp);
+	/*!
+	 * @brief 写入飞行记录
+	 */
+	void record(const LogStamp &stamp, int kind, int type, const struct iovec *parts, int n);
+	/*!
+	 * @brief 记录各调用点尚未报告的被抑制数量
+	 */
+	void report_suppressed();
+	/*!
+	 * @brief 格式化一行日志, 不含换行符
+	 * @return
+	 * 完整日志长度. 可能大于size
+	 */
+	int format_line(char *buf, int size, const LogStamp &stamp, const char *where, LOG_TYPE type,
+			const char *format, va_list vl);
+	/*!
+	 * @brief 格式化日志中时标之后的部分
+	 * @return
+	 * 完整长度. 可能大于size
+	 */
+	static int format_body(char *buf, int size, const char *where, LOG_TYPE type,
+			const char *format, va_list vl);
+	/*!
+	 * @brief 写入一条二进制记录
+	 * @param rec   记录. 负载位于记录头之后, 记录头由此函数填写
+	 * @param size  负载长度
+	 */
+	void write_record(const LogStamp &stamp, int kind, int type, uint32_t id, char *rec, int size);
+	/*!
+	 * @brief 写出二进制记录. 调用者持有mtx_, 格式首次出现在当前文件时先写出其定义
+	 */
+	void put_record(const std::tm &utc, const char *rec, int len);
+	/*!
+	 * @brief 同步写入一行日志
+	 */
+	void write_line(const LogStamp &stamp, const char *where, const char *text, int len);
+	/*!
+	 * @brief 写出一行文本日志并登记索引. 调用者持有mtx_
+	 */
+	void put_line(std::time_t sec, const char *where, const char *text, int len);
+	/*!
+	 * @brief 线程: 异步模式下批量写入日志
+	 */
+	void thread_write();
+	/*!
+	 * @brief 写出异步队列中的日志
+	 * @param fault 在信号处理函数中调用. 文件互斥锁被占用时不等待
+	 * @return
+	 * 写出行数
+	 */
+	int drain(bool fault = false);
+	/*!
+	 * @brief 信号处理函数
+	 */
+	static void on_fault(int signo);
 
 protected:
 	typedef std::unique_lock<std::mutex> mutex_lock;
+
+	struct LogLine {// 异步模式的一行日志
+		std::time_t sec;	//< UTC时刻
+		int len;			//< 长度, 含换行符
+		bool bin;			//< 二进制记录
+		char tag[GLOG_TAG_MAX];	//< 位置标签, 用于索引
+		char text[GLOG_LINE_MAX];	//< 日志
+	};
+	typedef MPSCQueue<LogLine> LineRing;
+
 	/* 成员变量 */
 	std::mutex	mtx_;		//< 互斥锁
 	FILE		*fd_;		//< 文件描述符
 	std::string	dirName_;	//< 日志目录
 	std::string prefix_;	//< 日志文件名前缀
-	int			dayOld_;	//< UTC日期
+	int			dayOld_;	//< 当前文件的UTC日期, YYYYMMDD
+	std::atomic<int> precision_;	//< 时标中秒以下的位数
+	std::atomic<bool> binary_;		//< 二进制模式
+	bool filebin_;					//< 已打开的文件为二进制格式
+	std::vector<uint8_t> defined_;	//< 已写入当前文件的格式定义
+	GLogLimiter limiter_;			//< 按调用点限流
+	GLogArchiver archiver_;			//< 关闭、压缩与清理已轮换的文件
+	GLogRecorder recorder_;			//< 飞行记录器
+	std::atomic<bool> recording_;	//< 飞行记录器已启用
+	GLogIndexWriter index_;			//< 索引
+	std::atomic<int> indexSec_;		//< 索引分桶宽度. 0: 不写入索引
+	uint64_t fileOff_;				//< 文本日志文件长度
+	std::string filePath_;			//< 当前日志文件路径
+	/* 异步模式 */
+	std::atomic<bool> async_;	//< 已启用异步模式
+	std::atomic<int> inflight_;	//< 正在写入队列的调用数量
+	std::unique_ptr<LineRing> ring_;	//< 环形队列
+	std::thread thrd_write_;	//< 写入线程
+	std::mutex mtx_wait_;		//< 互斥锁: 写入线程等待
+	std::condition_variable cv_wait_;	//< 唤醒写入线程
+	std::condition_variable cv_flushed_;	//< 通知刷新完成
+	std::atomic<bool> waiting_;	//< 写入线程等待中
+	std::atomic_flag draining_;	//< 正在读出队列
+	bool stop_;			//< 停止写入线程
+	int flush_ms_;		//< 刷新间隔
+	long flush_req_;	//< 刷新请求序号
+	long flushed_;		//< 已完成的刷新请求序号
 };
 
 extern GLog _gLog;		//< 工作日志
 
+/*!
+ * @brief 在调用点登记格式并记录日志. 格式编号在首次执行时登记
+ * @param log     GLog对象
+ * @param where   日志发生位置. 字符串常量或NULL
+ * @param type    日志类型
+ * @param format  日志格式. 字符串常量
+ */
+#define GLOG_BIN(log, where, type, format, ...) do {\
+	static const uint32_t _glog_fmt = GLog::RegisterFormat(where, type, format);\
+	(log).WriteBin(_glog_fmt, ##__VA_ARGS__);\
+} while (0)
+
+/*!
+ * @brief 按级别记录日志. 级别低于编译期最低级别或模块阈值时不求值参数
+ * @param log     GLog对象
+ * @param module  GLogModule对象
+ * @param level   日志级别
+ * @param where   日志发生位置
+ * @param type    日志类型
+ * @param format  日志格式
+ */
+#define GLOG_AT(log, module, level, where, type, format, ...) do {\
+	if ((level) >= GLOG_MIN_LEVEL && (module).Enabled(level))\
+		(log).Write(where, type, format, ##__VA_ARGS__);\
+} while (0)
+
+#define GLOG_TRACE(log, module, where, format, ...)		GLOG_AT(log, module, GLOG_LV_TRACE, where, LOG_NORMAL, format, ##__VA_ARGS__)
+#define GLOG_DEBUG(log, module, where, format, ...)		GLOG_AT(log, module, GLOG_LV_DEBUG, where, LOG_NORMAL, format, ##__VA_ARGS__)
+#define GLOG_INFO(log, module, where, format, ...)		GLOG_AT(log, module, GLOG_LV_INFO,  where, LOG_NORMAL, format, ##__VA_ARGS__)
+#define GLOG_WARNING(log, module, where, format, ...)	GLOG_AT(log, module, GLOG_LV_WARN,  where, LOG_WARN,   format, ##__VA_ARGS__)
+#define GLOG_ERROR(log, module, where, format, ...)		GLOG_AT(log, module, GLOG_LV_ERROR, where, LOG_FAULT,  format, ##__VA_ARGS__)
+
 #endif /* SRC_GLOG_H_ */
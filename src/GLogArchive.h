@@ -0,0 +1,396 @@
+/**
+ * @file GLogArchive.h 日志归档: 后台压缩已轮换的日志文件, 按时间与总量清理
+ * @version 0.1
+ * @date 2026-10-16
+ * @note
+ * - 日志文件轮换时, 写入方先打开新文件, 再将旧文件交给归档线程关闭. 写入方不等待磁盘操作
+ * - 归档线程以最低调度优先级运行, 将早于当前日期的日志文件压缩为gzip格式(.gz)
+ * - 清理规则: 删除早于保留天数的文件; 总量超限时从最早的文件开始删除. 当前文件不受影响
+ * - 文件名须为"前缀 + YYYYMMDD + 扩展名", 与GLog::valid_file()一致
+ * - 已存在同名压缩文件时, 新数据作为新的gzip成员追加在其后, 不覆盖已有归档. zlib读取时自动衔接
+ * - 停止归档线程时放弃正在进行的压缩, 保留原文件
+ * - 存在索引文件(.idx)的日志在分桶边界处分段压缩为多个gzip成员, 成员位置追加到索引后再压缩索引.
+ *   GLog::Query()据此从相关成员起点解压
+ */
+
+#ifndef SRC_GLOGARCHIVE_H_
+#define SRC_GLOGARCHIVE_H_
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <chrono>
+#include <ctime>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "GLogIndex.h"
+
+#define GLOG_ARCHIVE_SCAN	3600	///< 归档线程的最长检查周期, 量纲: 秒
+
+class GLogArchiver {
+protected:
+	typedef std::unique_lock<std::mutex> mutex_lock;
+
+	struct Retired {// 待关闭的文件
+		FILE* fp;		///< 文件
+		bool text;		///< 关闭前写入续接标记
+	};
+
+	struct Entry {// 目录中的日志文件
+		std::string name;	///< 文件名
+		int date;			///< 日期, YYYYMMDD
+		uint64_t size;		///< 文件长度
+	};
+
+	std::string dirName_;	///< 日志目录
+	std::string prefix_;	///< 文件名前缀
+	bool compress_;			///< 压缩已轮换的文件
+	int keepDays_;			///< 保留天数. 0: 不限
+	uint64_t maxBytes_;		///< 总量上限, 量纲: 字节. 0: 不限
+	int current_;			///< 当前日志文件的日期, YYYYMMDD
+
+	std::deque<Retired> retired_;	///< 待关闭的文件
+	std::mutex mtx_;				///< 互斥锁
+	std::condition_variable cv_;	///< 唤醒归档线程
+	std::thread thrd_;				///< 归档线程
+	bool running_;		///< 归档线程已启动
+	std::atomic<bool> stop_;	///< 停止归档线程
+	bool wake_;			///< 有待处理的工作
+
+public:
+	GLogArchiver() {
+		compress_ = false;
+		keepDays_ = 0;
+		maxBytes_ = 0;
+		current_  = 0;
+		running_  = false;
+		stop_     = false;
+		wake_     = false;
+	}
+
+	virtual ~GLogArchiver() {
+		Stop();
+	}
+
+	/*!
+	 * @brief 启用归档
+	 * @param dirName   日志目录, 以'/'结尾
+	 * @param prefix    文件名前缀
+	 * @param compress  压缩已轮换的文件
+	 * @param keepDays  保留天数. 0: 不限
+	 * @param maxBytes  总量上限, 量纲: 字节. 0: 不限
+	 */
+	void Start(const std::string& dirName, const std::string& prefix, bool compress, int keepDays, uint64_t maxBytes) {
+		mutex_lock lck(mtx_);
+		dirName_  = dirName;
+		prefix_   = prefix;
+		compress_ = compress;
+		keepDays_ = keepDays > 0 ? keepDays : 0;
+		maxBytes_ = maxBytes;
+		wake_     = true;
+		if (!running_) {
+			stop_    = false;
+			running_ = true;
+			thrd_ = std::thread(&GLogArchiver::thread_archive, this);
+		}
+		else cv_.notify_one();
+	}
+
+	/*!
+	 * @brief 停止归档线程. 关闭全部待关闭的文件后返回
+	 */
+	void Stop() {
+		{
+			mutex_lock lck(mtx_);
+			if (!running_) return;
+			stop_ = true;
+			cv_.notify_one();
+		}
+		thrd_.join();
+		mutex_lock lck(mtx_);
+		running_ = false;
+		for (size_t i = 0; i < retired_.size(); ++i) close(retired_[i]);
+		retired_.clear();
+	}
+
+	/*!
+	 * @brief 移交已轮换的文件. 归档线程未启动时立即关闭
+	 * @param fp    文件
+	 * @param text  关闭前写入续接标记
+	 * @param date  新文件的日期, YYYYMMDD
+	 */
+	void Retire(FILE* fp, bool text, int date) {
+		Retired r;
+		r.fp   = fp;
+		r.text = text;
+		{
+			mutex_lock lck(mtx_);
+			if (date > current_) current_ = date;
+			if (running_ && !stop_) {
+				retired_.push_back(r);
+				wake_ = true;
+				cv_.notify_one();
+				return;
+			}
+		}
+		close(r);
+	}
+
+	/*!
+	 * @brief 登记当前日志文件的日期
+	 */
+	void SetCurrent(int date) {
+		mutex_lock lck(mtx_);
+		if (date > current_) {
+			current_ = date;
+			wake_    = true;
+			if (running_) cv_.notify_one();
+		}
+	}
+
+protected:
+	static void close(const Retired& r) {
+		if (r.text) fprintf(r.fp, "%s continue\n", std::string(69, '>').c_str());
+		fclose(r.fp);
+	}
+
+	void thread_archive() {
+#ifdef SCHED_IDLE
+		struct sched_param param;
+		memset(&param, 0, sizeof(param));
+		pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+#endif
+		std::deque<Retired> retired;
+		bool stop;
+
+		do {
+			{
+				mutex_lock lck(mtx_);
+				if (!stop_ && !wake_)
+					cv_.wait_for(lck, std::chrono::seconds(GLOG_ARCHIVE_SCAN));
+				retired.swap(retired_);
+				stop  = stop_;
+				wake_ = false;
+			}
+			for (size_t i = 0; i < retired.size(); ++i) close(retired[i]);
+			retired.clear();
+			if (!stop) scan();
+		} while (!stop);
+	}
+
+	/*!
+	 * @brief 压缩并清理目录中的日志文件
+	 */
+	void scan() {
+		std::string dirName, prefix;
+		bool compress;
+		int keepDays, current;
+		uint64_t maxBytes;
+		{
+			mutex_lock lck(mtx_);
+			dirName  = dirName_;
+			prefix   = prefix_;
+			compress = compress_;
+			keepDays = keepDays_;
+			maxBytes = maxBytes_;
+			current  = current_;
+		}
+		if (!current) return;
+
+		std::vector<Entry> entries;
+		DIR* dir = opendir(dirName.c_str());
+		if (!dir) return;
+		for (struct dirent* ent; (ent = readdir(dir)) != NULL; ) {
+			Entry entry;
+			entry.name = ent->d_name;
+			if (parse(entry.name, prefix, entry.date)) entries.push_back(entry);
+		}
+		closedir(dir);
+
+		// 压缩早于当前日期的文件. 按名称排列, 日志文件先于其索引文件压缩
+		std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+			return a.name < b.name;
+		});
+		for (size_t i = 0; i < entries.size(); ++i) {
+			Entry& entry = entries[i];
+			if (stop_.load(std::memory_order_relaxed)) return;
+			if (compress && entry.date < current && !ends_with(entry.name, ".gz") && !ends_with(entry.name, ".tmp")) {
+				std::string path = dirName + entry.name;
+				if (gzip(path)) entry.name += ".gz";
+			}
+			struct stat st;
+			entry.size = stat((dirName + entry.name).c_str(), &st) ? 0 : uint64_t(st.st_size);
+		}
+
+		// 清理: 最早的文件在前
+		std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+			return a.date < b.date || (a.date == b.date && a.name < b.name);
+		});
+		uint64_t total(0);
+		for (size_t i = 0; i < entries.size(); ++i) total += entries[i].size;
+		int oldest = keepDays ? date_before(current, keepDays) : 0;
+		for (size_t i = 0; i < entries.size(); ++i) {
+			Entry& entry = entries[i];
+			if (entry.date >= current) break;
+			if (entry.date < oldest || (maxBytes && total > maxBytes)) {
+				if (!unlink((dirName + entry.name).c_str())) total -= entry.size;
+			}
+		}
+	}
+
+	/*!
+	 * @brief 解析文件名
+	 * @return
+	 * 文件名为"前缀 + YYYYMMDD + 扩展名"时返回true
+	 */
+	static bool parse(const std::string& name, const std::string& prefix, int& date) {
+		if (name.compare(0, prefix.size(), prefix) || name.size() < prefix.size() + 9) return false;
+		date = 0;
+		for (size_t i = prefix.size(); i < prefix.size() + 8; ++i) {
+			if (name[i] < '0' || name[i] > '9') return false;
+			date = date * 10 + (name[i] - '0');
+		}
+		return name[prefix.size() + 8] == '.';
+	}
+
+	static bool ends_with(const std::string& s, const char* tail) {
+		size_t n = strlen(tail);
+		return s.size() >= n && !s.compare(s.size() - n, n, tail);
+	}
+
+	/*!
+	 * @brief 日期date之前days天的日期, YYYYMMDD
+	 */
+	static int date_before(int date, int days) {
+		std::tm tm;
+		memset(&tm, 0, sizeof(tm));
+		tm.tm_year = date / 10000 - 1900;
+		tm.tm_mon  = date / 100 % 100 - 1;
+		tm.tm_mday = date % 100 - days;
+		tm.tm_hour = 12;
+		std::time_t t = timegm(&tm);
+		gmtime_r(&t, &tm);
+		return (tm.tm_year + 1900) * 10000 + (tm.tm_mon + 1) * 100 + tm.tm_mday;
+	}
+
+	/*!
+	 * @brief 将文件压缩为path.gz, 成功后删除原文件. path.gz已存在时追加在其后
+	 * @return
+	 * 压缩结果. 停止归档线程时放弃压缩并返回false
+	 * @note
+	 * 存在未压缩的索引文件path.idx且path.gz不存在时, 在分桶边界处开始新的gzip成员,
+	 * 每个成员压缩前不少于GLOG_GZ_MEMBER字节. 成员位置追加到索引文件
+	 */
+	bool gzip(const std::string& path) {
+		std::string tmp = path + ".gz.tmp", gz = path + ".gz", idx = path + ".idx";
+		bool exists = !access(gz.c_str(), F_OK);	// 已归档后重新出现的日志: 追加为新的gzip成员
+		std::vector<uint64_t> bounds;	// 分桶边界
+		std::vector<GLogIndexMember> members;
+		GLogIndexReader index;
+		if (!exists && !ends_with(path, ".idx") && index.Load(idx.c_str())) {
+			for (size_t i = 0; i < index.buckets.size(); ++i) bounds.push_back(index.buckets[i].offset);
+		}
+
+		FILE* in = fopen(path.c_str(), "rb");
+		if (!in) return false;
+		int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		gzFile out = fd < 0 ? NULL : open_member(fd, 0, members);
+		if (!out) {
+			if (fd >= 0) ::close(fd);
+			fclose(in);
+			unlink(tmp.c_str());
+			return false;
+		}
+
+		std::vector<char> buf(65536);
+		uint64_t done(0), start(0);	// 已压缩长度, 当前成员起点
+		size_t n, next(0), len;
+		bool ok(true);
+		while (ok && !stop_.load(std::memory_order_relaxed) && (n = fread(buf.data(), 1, buf.size(), in)) > 0) {
+			for (size_t pos = 0; ok && pos < n; pos += len, done += len) {
+				while (next < bounds.size() && bounds[next] < done) ++next;
+				if (next < bounds.size() && bounds[next] == done && done - start >= GLOG_GZ_MEMBER) {// 新成员
+					ok = gzclose(out) == Z_OK;
+					if (ok) ok = (out = open_member(fd, done, members)) != NULL;
+					else out = NULL;
+					start = done;
+					if (!ok) break;
+				}
+				while (next < bounds.size() && bounds[next] <= done) ++next;
+				len = n - pos;
+				if (next < bounds.size() && bounds[next] - done < len) len = size_t(bounds[next] - done);
+				ok = gzwrite(out, buf.data() + pos, unsigned(len)) == int(len);
+			}
+		}
+		if (out) ok = gzclose(out) == Z_OK && ok;
+		ok = !ferror(in) && !::close(fd) && ok && !stop_.load(std::memory_order_relaxed);
+		fclose(in);
+		if (ok) {
+			if (!exists) ok = !rename(tmp.c_str(), gz.c_str());
+			else ok = append(tmp, gz);
+		}
+		if (ok && bounds.size()) GLogIndexWriter::AppendMembers(idx, members);
+		if (ok) unlink(path.c_str());
+		unlink(tmp.c_str());
+		return ok;
+	}
+
+	/*!
+	 * @brief 在文件末尾开始新的gzip成员
+	 * @param fd       压缩文件
+	 * @param offset   成员起点在原文件中的偏移量
+	 * @param members  成员位置
+	 */
+	static gzFile open_member(int fd, uint64_t offset, std::vector<GLogIndexMember>& members) {
+		GLogIndexMember member;
+		off_t pos = lseek(fd, 0, SEEK_END);
+		int dupfd = pos < 0 ? -1 : dup(fd);
+		gzFile out = dupfd < 0 ? NULL : gzdopen(dupfd, "wb6");
+		if (!out) {
+			if (dupfd >= 0) ::close(dupfd);
+			return NULL;
+		}
+		member.offset  = offset;
+		member.zoffset = uint64_t(pos);
+		members.push_back(member);
+		return out;
+	}
+
+	/*!
+	 * @brief 将文件from的内容追加到文件to之后
+	 */
+	static bool append(const std::string& from, const std::string& to) {
+		FILE* in = fopen(from.c_str(), "rb");
+		if (!in) return false;
+		FILE* out = fopen(to.c_str(), "ab");
+		if (!out) {
+			fclose(in);
+			return false;
+		}
+
+		std::vector<char> buf(65536);
+		size_t n;
+		bool ok(true);
+		while (ok && (n = fread(buf.data(), 1, buf.size(), in)) > 0)
+			ok = fwrite(buf.data(), 1, n, out) == n;
+		ok = !ferror(in) && !fclose(out) && ok;
+		fclose(in);
+		return ok;
+	}
+};
+
+#endif /* SRC_GLOGARCHIVE_H_ */
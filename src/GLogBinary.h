@@ -0,0 +1,223 @@
+/**
+ * @file GLogBinary.h 二进制日志: 格式字符串登记表、参数编码与记录格式
+ * @version 0.1
+ * @date 2026-10-16
+ * @note
+ * - 文件格式: 8字节文件标识 + 记录序列. 记录由记录头和负载构成
+ * - 格式记录: 负载为"位置\0格式\0". 每个文件在首次使用某格式前写入其定义
+ * - 参数记录: 负载为参数序列, 每个参数由1字节类型标记和值构成.
+ *   整数统一为8字节, 浮点数为double, 字符串为2字节长度 + 字节
+ * - 文本记录: 负载为格式化后的"类型 位置, 内容", 用于二进制模式下的普通Write()
+ * - 格式字符串和位置须为静态存储期的字符串, 登记表仅保存其地址
+ */
+
+#ifndef SRC_GLOGBINARY_H_
+#define SRC_GLOGBINARY_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <type_traits>
+
+#define GLOG_BIN_MAGIC	"LXMGLB1"	///< 文件标识
+#define GLOG_FORMAT_MAX	4096		///< 可登记的格式数量
+
+enum {// 记录类型
+	GLR_FORMAT = 1,	///< 格式定义
+	GLR_ENTRY,		///< 格式编号 + 参数
+	GLR_TEXT		///< 已格式化的文本
+};
+
+enum {// 参数类型标记
+	GLA_INT    = 'i',	///< 有符号整数
+	GLA_UINT   = 'u',	///< 无符号整数
+	GLA_DOUBLE = 'f',	///< 浮点数
+	GLA_STR    = 's',	///< 字符串
+	GLA_PTR    = 'p'	///< 指针
+};
+
+/*!
+ * @struct GLogRecord 记录头, 其后为负载
+ */
+struct GLogRecord {
+	uint16_t length;	///< 记录长度, 含记录头
+	uint8_t kind;		///< 记录类型
+	uint8_t type;		///< 日志类型
+	uint32_t id;		///< 格式编号
+	int64_t stamp;		///< UTC时刻, 量纲: 纳秒, 相对1970-01-01
+};
+
+/*!
+ * @struct GLogFormat 已登记的格式
+ */
+struct GLogFormat {
+	const char* where;	///< 日志发生位置. 可为NULL
+	int type;			///< 日志类型
+	const char* format;	///< 格式字符串
+};
+
+/*!
+ * @class GLogFormats 进程内的格式登记表. 登记加锁, 查找无锁
+ */
+class GLogFormats {
+public:
+	/*!
+	 * @brief 登记格式
+	 * @return
+	 * 格式编号. 登记表已满时返回GLOG_FORMAT_MAX
+	 */
+	static uint32_t Register(const char* where, int type, const char* format) {
+		std::lock_guard<std::mutex> lck(mutex());
+		uint32_t n = count().load(std::memory_order_relaxed);
+		if (n >= GLOG_FORMAT_MAX) return GLOG_FORMAT_MAX;
+		GLogFormat& fmt = table()[n];
+		fmt.where  = where;
+		fmt.type   = type;
+		fmt.format = format;
+		count().store(n + 1, std::memory_order_release);
+		return n;
+	}
+
+	/*!
+	 * @brief 查找格式
+	 * @return
+	 * 未登记时返回NULL
+	 */
+	static const GLogFormat* Get(uint32_t id) {
+		return id < count().load(std::memory_order_acquire) ? &table()[id] : NULL;
+	}
+
+protected:
+	static GLogFormat* table() {
+		static GLogFormat formats[GLOG_FORMAT_MAX];
+		return formats;
+	}
+
+	static std::atomic<uint32_t>& count() {
+		static std::atomic<uint32_t> n(0);
+		return n;
+	}
+
+	static std::mutex& mutex() {
+		static std::mutex mtx;
+		return mtx;
+	}
+};
+
+/*!
+ * @class GLogEncoder 将参数编码至缓冲区. 缓冲区不足时截断字符串, 丢弃其后的参数
+ */
+class GLogEncoder {
+protected:
+	char* buf_;		///< 缓冲区
+	int size_;		///< 缓冲区长度
+	int n_;			///< 已写入长度
+	bool full_;		///< 缓冲区已满
+
+public:
+	GLogEncoder(char* buf, int size) {
+		buf_  = buf;
+		size_ = size;
+		n_    = 0;
+		full_ = false;
+	}
+
+	int Size() const {
+		return n_;
+	}
+
+	void Args() {}
+
+	template<typename T, typename... Rest>
+	void Args(const T& v, const Rest&... rest) {
+		Put(v);
+		Args(rest...);
+	}
+
+	void Put(const char* s) {
+		put_str(s, s ? strlen(s) : 0);
+	}
+
+	void Put(char* s) {
+		Put((const char*) s);
+	}
+
+	void Put(const std::string& s) {
+		put_str(s.data(), s.size());
+	}
+
+	template<typename T>
+	void Put(const T& v) {
+		put_scalar(v, std::integral_constant<int,
+				std::is_floating_point<T>::value ? 0 :
+				(std::is_integral<T>::value || std::is_enum<T>::value) ? (std::is_signed<T>::value || std::is_enum<T>::value ? 1 : 2) :
+				std::is_pointer<T>::value ? 3 : -1>());
+	}
+
+protected:
+	bool put_raw(char tag, const void* v, int n) {
+		if (full_ || n_ + 1 + n > size_) {
+			full_ = true;
+			return false;
+		}
+		buf_[n_] = tag;
+		memcpy(buf_ + n_ + 1, v, n);
+		n_ += n + 1;
+		return true;
+	}
+
+	void put_str(const char* s, size_t len) {
+		if (full_) return;
+		int room = size_ - n_ - 3;
+		if (room < 0) {
+			full_ = true;
+			return;
+		}
+		uint16_t n = uint16_t(len < size_t(room) ? len : size_t(room));
+		buf_[n_] = GLA_STR;
+		memcpy(buf_ + n_ + 1, &n, 2);
+		if (n) memcpy(buf_ + n_ + 3, s, n);
+		n_ += n + 3;
+		if (n < len) full_ = true;
+	}
+
+	template<typename T>
+	void put_scalar(const T& v, std::integral_constant<int, 0>) {
+		double x = double(v);
+		put_raw(GLA_DOUBLE, &x, 8);
+	}
+
+	template<typename T>
+	void put_scalar(const T& v, std::integral_constant<int, 1>) {
+		int64_t x = int64_t(v);
+		put_raw(GLA_INT, &x, 8);
+	}
+
+	template<typename T>
+	void put_scalar(const T& v, std::integral_constant<int, 2>) {
+		uint64_t x = uint64_t(v);
+		put_raw(GLA_UINT, &x, 8);
+	}
+
+	template<typename T>
+	void put_scalar(const T& v, std::integral_constant<int, 3>) {
+		uint64_t x = uint64_t(uintptr_t(v));
+		put_raw(GLA_PTR, &x, 8);
+	}
+};
+
+/*!
+ * @brief 文本模式下即时格式化WriteBin()的参数: std::string转换为C字符串
+ */
+template<typename T>
+inline const T& glog_arg(const T& v) {
+	return v;
+}
+
+inline const char* glog_arg(const std::string& s) {
+	return s.c_str();
+}
+
+#endif /* SRC_GLOGBINARY_H_ */
@@ -0,0 +1,278 @@
+/**
+ * @file GLogIndex.h 日志索引: 文本日志的时间分桶与位置标签到文件偏移量的映射
+ * @version 0.1
+ * @date 2026-10-16
+ * @note
+ * - 索引文件为日志文件名加".idx", 由8字节文件标识和定长记录构成
+ * - 每个时间分桶记录其首行的偏移量. 每个位置标签在其出现的分桶中仅记录一次
+ * - 日志文件每次打开时写入会话记录, 标签编号在会话内有效
+ * - 读取使用zlib接口, 兼容归档压缩后的索引文件
+ * - 归档压缩日志文件时, 在分桶边界处开始新的gzip成员, 并将成员位置追加到索引. 查询已压缩的
+ *   日志时从相关分桶所在成员的起点解压, 不必从文件头解压
+ */
+
+#ifndef SRC_GLOGINDEX_H_
+#define SRC_GLOGINDEX_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <zlib.h>
+#include <algorithm>
+#include <ctime>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define GLOG_IDX_MAGIC	"LXMGLI1"	///< 文件标识
+#define GLOG_IDX_BUCKET	60			///< 缺省分桶宽度, 量纲: 秒
+
+enum {// 索引记录类型
+	GLI_SESSION = 1,	///< 会话: key为分桶宽度, value为打开时的文件偏移量
+	GLI_BUCKET,			///< 分桶: key为起始UTC秒, value为首行偏移量
+	GLI_TAGDEF,			///< 标签定义: key为标签编号, 其后为len字节的名称, 按8字节对齐
+	GLI_TAG,			///< 标签出现: key为标签编号, value为所在分桶的偏移量
+	GLI_MEMBER			///< gzip成员: value为成员起点在原文件中的偏移量, 其后8字节为成员在压缩文件中的偏移量
+};
+
+#define GLOG_GZ_MEMBER	65536	///< 压缩日志时gzip成员的最小长度(压缩前), 量纲: 字节
+
+/*!
+ * @struct GLogIndexMember 压缩日志文件中的gzip成员
+ */
+struct GLogIndexMember {
+	uint64_t offset;	///< 成员起点在原文件中的偏移量
+	uint64_t zoffset;	///< 成员在压缩文件中的偏移量
+};
+
+/*!
+ * @struct GLogIndexRecord 索引记录
+ */
+struct GLogIndexRecord {
+	uint8_t kind;		///< 记录类型
+	uint8_t reserved;
+	uint16_t len;		///< 附加数据长度
+	uint32_t key;		///< 键
+	uint64_t value;		///< 值
+};
+
+/*!
+ * @class GLogIndexWriter 写入索引. 由持有日志文件互斥锁的线程调用
+ */
+class GLogIndexWriter {
+protected:
+	FILE* fp_;				///< 索引文件
+	int bucketSec_;			///< 分桶宽度, 量纲: 秒
+	int64_t bucket_;		///< 当前分桶编号. -1: 无
+	uint64_t bucketOff_;	///< 当前分桶的偏移量
+	std::unordered_map<std::string, uint32_t> tags_;	///< 标签编号
+	std::vector<int64_t> tagBucket_;	///< 各标签最近出现的分桶编号
+	bool dirty_;			///< 有未刷新的记录
+
+public:
+	GLogIndexWriter() {
+		fp_        = NULL;
+		bucketSec_ = GLOG_IDX_BUCKET;
+		bucket_    = -1;
+		bucketOff_ = 0;
+		dirty_     = false;
+	}
+
+	virtual ~GLogIndexWriter() {
+		Close();
+	}
+
+	/*!
+	 * @brief 打开索引文件
+	 * @param path       索引文件路径
+	 * @param bucketSec  分桶宽度, 量纲: 秒
+	 * @param offset     日志文件的当前长度
+	 */
+	bool Open(const std::string& path, int bucketSec, uint64_t offset) {
+		Close();
+		if ((fp_ = fopen(path.c_str(), "a+")) == NULL) return false;
+		fseek(fp_, 0, SEEK_END);
+		if (!ftell(fp_)) fwrite(GLOG_IDX_MAGIC, 1, sizeof(GLOG_IDX_MAGIC), fp_);
+		bucketSec_ = bucketSec > 0 ? bucketSec : GLOG_IDX_BUCKET;
+		bucket_    = -1;
+		tags_.clear();
+		tagBucket_.clear();
+		put(GLI_SESSION, uint32_t(bucketSec_), offset);
+		return true;
+	}
+
+	void Close() {
+		if (fp_) {
+			fclose(fp_);
+			fp_ = NULL;
+		}
+		dirty_ = false;
+	}
+
+	bool IsOpen() const {
+		return fp_ != NULL;
+	}
+
+	/*!
+	 * @brief 交出索引文件, 由调用者关闭
+	 */
+	FILE* Detach() {
+		FILE* fp = fp_;
+		fp_    = NULL;
+		dirty_ = false;
+		return fp;
+	}
+
+	/*!
+	 * @brief 登记一行日志
+	 * @param sec     UTC秒
+	 * @param tag     位置标签. 可为NULL或空字符串
+	 * @param offset  该行在日志文件中的偏移量
+	 */
+	void Line(std::time_t sec, const char* tag, uint64_t offset) {
+		int64_t bucket = int64_t(sec) / bucketSec_;
+		if (bucket != bucket_) {
+			bucket_    = bucket;
+			bucketOff_ = offset;
+			put(GLI_BUCKET, uint32_t(bucket * bucketSec_), offset);
+		}
+		if (!tag || !*tag) return;
+
+		uint32_t id;
+		std::unordered_map<std::string, uint32_t>::iterator it = tags_.find(tag);
+		if (it != tags_.end()) id = it->second;
+		else {// 新标签
+			id = uint32_t(tags_.size());
+			tags_[tag] = id;
+			tagBucket_.push_back(-1);
+			size_t len = strlen(tag);
+			if (len > 0xFFFF) len = 0xFFFF;
+			char pad[8] = { 0 };
+			put(GLI_TAGDEF, id, 0, uint16_t(len));
+			fwrite(tag, 1, len, fp_);
+			fwrite(pad, 1, (8 - len % 8) % 8, fp_);
+		}
+		if (tagBucket_[id] != bucket_) {
+			tagBucket_[id] = bucket_;
+			put(GLI_TAG, id, bucketOff_);
+		}
+	}
+
+	/*!
+	 * @brief 刷新索引文件
+	 */
+	void Flush() {
+		if (dirty_) {
+			fflush(fp_);
+			dirty_ = false;
+		}
+	}
+
+	/*!
+	 * @brief 将gzip成员位置追加到索引文件. 由归档线程在压缩日志文件后调用
+	 * @param path     索引文件路径
+	 * @param members  成员位置, 按偏移量排列
+	 */
+	static bool AppendMembers(const std::string& path, const std::vector<GLogIndexMember>& members) {
+		FILE* fp = fopen(path.c_str(), "ab");
+		if (!fp) return false;
+		GLogIndexRecord rec;
+		bool ok(true);
+		rec.kind     = GLI_MEMBER;
+		rec.reserved = 0;
+		rec.len      = sizeof(uint64_t);
+		rec.key      = 0;
+		for (size_t i = 0; ok && i < members.size(); ++i) {
+			rec.value = members[i].offset;
+			ok = fwrite(&rec, sizeof(rec), 1, fp) == 1 && fwrite(&members[i].zoffset, sizeof(uint64_t), 1, fp) == 1;
+		}
+		return !fclose(fp) && ok;
+	}
+
+protected:
+	void put(int kind, uint32_t key, uint64_t value, uint16_t len = 0) {
+		GLogIndexRecord rec;
+		rec.kind     = uint8_t(kind);
+		rec.reserved = 0;
+		rec.len      = len;
+		rec.key      = key;
+		rec.value    = value;
+		fwrite(&rec, sizeof(rec), 1, fp_);
+		dirty_ = true;
+	}
+};
+
+/*!
+ * @class GLogIndexReader 读取索引
+ */
+class GLogIndexReader {
+public:
+	struct Bucket {
+		int64_t start;		///< 起始UTC秒
+		int width;			///< 分桶宽度, 量纲: 秒
+		uint64_t offset;	///< 首行偏移量
+	};
+
+	std::vector<Bucket> buckets;	///< 分桶, 按偏移量排列
+	std::map<std::string, std::vector<uint64_t> > tags;	///< 标签出现的分桶偏移量
+	std::vector<GLogIndexMember> members;	///< 压缩日志文件的gzip成员, 按偏移量排列. 空: 未记录
+
+public:
+	/*!
+	 * @brief 读取索引文件. 可为gzip压缩文件
+	 */
+	bool Load(const char* path) {
+		buckets.clear();
+		tags.clear();
+		members.clear();
+
+		gzFile fp = gzopen(path, "rb");
+		char head[sizeof(GLOG_IDX_MAGIC)];
+		if (!fp) return false;
+		if (gzread(fp, head, sizeof(head)) != int(sizeof(head)) || memcmp(head, GLOG_IDX_MAGIC, sizeof(head))) {
+			gzclose(fp);
+			return false;
+		}
+
+		GLogIndexRecord rec;
+		std::vector<std::string> names;	// 当前会话的标签名称
+		std::vector<char> name;
+		int width(GLOG_IDX_BUCKET);
+		while (gzread(fp, &rec, sizeof(rec)) == int(sizeof(rec))) {
+			if (rec.kind == GLI_SESSION) {
+				width = rec.key ? int(rec.key) : GLOG_IDX_BUCKET;
+				names.clear();
+			}
+			else if (rec.kind == GLI_BUCKET) {
+				Bucket bucket;
+				bucket.start  = int64_t(rec.key);
+				bucket.width  = width;
+				bucket.offset = rec.value;
+				buckets.push_back(bucket);
+			}
+			else if (rec.kind == GLI_TAGDEF) {
+				name.resize((rec.len + 7) & ~7);
+				if (!name.empty() && gzread(fp, name.data(), unsigned(name.size())) != int(name.size())) break;
+				if (names.size() <= rec.key) names.resize(rec.key + 1);
+				names[rec.key].assign(name.data(), rec.len);
+			}
+			else if (rec.kind == GLI_TAG && rec.key < names.size()) {
+				tags[names[rec.key]].push_back(rec.value);
+			}
+			else if (rec.kind == GLI_MEMBER) {
+				GLogIndexMember member;
+				member.offset = rec.value;
+				if (gzread(fp, &member.zoffset, sizeof(uint64_t)) != int(sizeof(uint64_t))) break;
+				members.push_back(member);
+			}
+		}
+		gzclose(fp);
+		std::stable_sort(buckets.begin(), buckets.end(), [](const Bucket& a, const Bucket& b) {
+			return a.offset < b.offset;
+		});
+		return true;
+	}
+};
+
+#endif /* SRC_GLOGINDEX_H_ */
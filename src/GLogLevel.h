@@ -0,0 +1,116 @@
+/**
+ * @file GLogLevel.h 日志级别: 编译期最低级别与按模块的运行期阈值
+ * @version 0.1
+ * @date 2026-10-16
+ * @note
+ * - 低于GLOG_MIN_LEVEL的日志在编译期被消除. 编译时以-DGLOG_MIN_LEVEL=n调整
+ * - 模块以GLOG_MODULE()定义, 阈值为原子量. 日志宏在求值参数之前以一次relaxed读取比较阈值
+ * - 模块按名称登记, 可在运行期以GLogModule::SetLevel()调整
+ */
+
+#ifndef SRC_GLOGLEVEL_H_
+#define SRC_GLOGLEVEL_H_
+
+#include <string.h>
+#include <atomic>
+#include <mutex>
+
+enum GLOG_LEVEL {// 日志级别
+	GLOG_LV_TRACE,	///< 跟踪
+	GLOG_LV_DEBUG,	///< 调试
+	GLOG_LV_INFO,	///< 一般
+	GLOG_LV_WARN,	///< 警告
+	GLOG_LV_ERROR,	///< 错误
+	GLOG_LV_OFF		///< 关闭
+};
+
+#ifndef GLOG_MIN_LEVEL
+#define GLOG_MIN_LEVEL	GLOG_LV_TRACE	///< 编译期最低级别
+#endif
+
+class GLogModule {
+protected:
+	const char* name_;			///< 模块名称
+	std::atomic<int> level_;	///< 运行期阈值
+	GLogModule* next_;			///< 登记表中的下一模块
+
+public:
+	/*!
+	 * @param name  模块名称. 须为静态存储期的字符串
+	 * @param level 初始阈值
+	 */
+	GLogModule(const char* name, int level = GLOG_LV_INFO) {
+		name_  = name;
+		level_ = level;
+		std::lock_guard<std::mutex> lck(mutex());
+		next_  = head();
+		head() = this;
+	}
+
+	virtual ~GLogModule() {
+		std::lock_guard<std::mutex> lck(mutex());
+		for (GLogModule** p = &head(); *p; p = &(*p)->next_) {
+			if (*p == this) {
+				*p = next_;
+				break;
+			}
+		}
+	}
+
+	const char* Name() const {
+		return name_;
+	}
+
+	int Level() const {
+		return level_.load(std::memory_order_relaxed);
+	}
+
+	bool Enabled(int level) const {
+		return level >= level_.load(std::memory_order_relaxed);
+	}
+
+	void SetLevel(int level) {
+		level_.store(level, std::memory_order_relaxed);
+	}
+
+	/*!
+	 * @brief 按名称设置模块阈值
+	 * @param name  模块名称. "*": 全部模块
+	 * @param level 阈值
+	 * @return
+	 * 匹配的模块数量
+	 */
+	static int SetLevel(const char* name, int level) {
+		std::lock_guard<std::mutex> lck(mutex());
+		int n(0);
+		bool all = !strcmp(name, "*");
+		for (GLogModule* p = head(); p; p = p->next_) {
+			if (all || !strcmp(p->name_, name)) {
+				p->SetLevel(level);
+				++n;
+			}
+		}
+		return n;
+	}
+
+protected:
+	static GLogModule*& head() {
+		static GLogModule* first = NULL;
+		return first;
+	}
+
+	static std::mutex& mutex() {
+		static std::mutex mtx;
+		return mtx;
+	}
+};
+
+/*!
+ * @brief 定义模块
+ * @param var   模块变量名
+ * @param name  模块名称
+ * @param ...   可选初始阈值, 缺省为GLOG_LV_INFO
+ */
+#define GLOG_MODULE(var, name, ...) static GLogModule var(name, ##__VA_ARGS__)
+
+#endif /* SRC_GLOGLEVEL_H_ */
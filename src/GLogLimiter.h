@@ -0,0 +1,155 @@
+/**
+ * @file GLogLimiter.h 日志限流: 按调用点的令牌桶, 统计被抑制的日志数量
+ * @version 0.1
+ * @date 2026-10-16
+ * @note
+ * - 以(格式字符串地址, 日志发生位置, 日志类型)标识调用点. 格式字符串为常量时, 同一调用点的地址不变;
+ *   共用格式字符串(如"%s")的不同位置互不影响. 位置按内容比较, 至多比较GLOG_LIMIT_WHERE-1个字符
+ * - 令牌桶以GCRA(理论到达时刻)实现, 每个调用点仅一个原子量, 无锁
+ * - 调用点表为开放寻址, 容量GLOG_LIMIT_SLOTS. 表满时新调用点不限流
+ */
+
+#ifndef SRC_GLOGLIMITER_H_
+#define SRC_GLOGLIMITER_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+
+#define GLOG_LIMIT_SLOTS	1024	///< 调用点表容量, 2的幂
+#define GLOG_LIMIT_WHERE	48		///< 调用点记录的位置长度, 含结束符
+
+class GLogLimiter {
+protected:
+	struct Slot {
+		std::atomic<const void*> key;		///< 调用点
+		std::atomic<int64_t> tat;			///< 理论到达时刻, 量纲: 纳秒
+		std::atomic<uint32_t> suppressed;	///< 被抑制的数量
+		char where[GLOG_LIMIT_WHERE];	///< 日志发生位置. 空字符串: 无
+		int type;			///< 日志类型
+	};
+
+	Slot slots_[GLOG_LIMIT_SLOTS];		///< 调用点表
+	std::atomic<int64_t> interval_;		///< 令牌间隔, 量纲: 纳秒. 0: 不限流
+	std::atomic<int64_t> tolerance_;	///< 突发容限, 量纲: 纳秒
+
+public:
+	GLogLimiter() {
+		for (int i = 0; i < GLOG_LIMIT_SLOTS; ++i) {
+			slots_[i].key        = NULL;
+			slots_[i].tat        = 0;
+			slots_[i].suppressed = 0;
+			slots_[i].where[0]   = 0;
+			slots_[i].type       = 0;
+		}
+		interval_  = 0;
+		tolerance_ = 0;
+	}
+
+	/*!
+	 * @brief 设置限流参数
+	 * @param rate   每个调用点每秒允许的日志数量. <= 0: 不限流
+	 * @param burst  允许的突发数量
+	 */
+	void Set(double rate, int burst) {
+		int64_t interval = rate > 0.0 ? int64_t(1E9 / rate) : 0;
+		if (rate > 0.0 && interval < 1) interval = 1;
+		tolerance_.store(burst > 1 ? interval * (burst - 1) : 0, std::memory_order_relaxed);
+		interval_.store(interval, std::memory_order_relaxed);
+	}
+
+	bool Enabled() const {
+		return interval_.load(std::memory_order_relaxed) != 0;
+	}
+
+	/*!
+	 * @brief 检查调用点是否可记录日志
+	 * @param key    调用点
+	 * @param where  日志发生位置
+	 * @param type   日志类型
+	 * @param now    当前时刻, 量纲: 纳秒
+	 * @param folded 允许记录时, 返回此前被抑制的数量
+	 * @return
+	 * 允许记录时返回true
+	 */
+	bool Admit(const void* key, const char* where, int type, int64_t now, uint32_t& folded) {
+		folded = 0;
+		int64_t interval = interval_.load(std::memory_order_relaxed);
+		if (!interval) return true;
+		Slot* slot = find(key, where ? where : "", type);
+		if (!slot) return true;
+
+		int64_t tolerance = tolerance_.load(std::memory_order_relaxed);
+		int64_t tat = slot->tat.load(std::memory_order_relaxed), next;
+		do {
+			if (now < tat - tolerance) {// 令牌耗尽
+				slot->suppressed.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			next = (tat > now ? tat : now) + interval;
+		} while (!slot->tat.compare_exchange_weak(tat, next, std::memory_order_relaxed));
+		if (slot->suppressed.load(std::memory_order_relaxed))
+			folded = slot->suppressed.exchange(0, std::memory_order_relaxed);
+		return true;
+	}
+
+	/*!
+	 * @brief 取出各调用点被抑制的数量
+	 * @param report 回调函数, 形式为report(const char* where, int type, uint32_t n). where可为NULL
+	 */
+	template<typename Report>
+	void Collect(Report report) {
+		for (int i = 0; i < GLOG_LIMIT_SLOTS; ++i) {
+			Slot& slot = slots_[i];
+			const void* k = slot.key.load(std::memory_order_acquire);
+			if (!k || k == claim()) continue;
+			uint32_t n = slot.suppressed.exchange(0, std::memory_order_relaxed);
+			if (n) report(slot.where[0] ? slot.where : (const char*) NULL, slot.type, n);
+		}
+	}
+
+protected:
+	/*!
+	 * @brief 占位标记: 槽位已被占用, 位置与类型尚未写入
+	 */
+	static const void* claim() {
+		return (const void*) uintptr_t(1);
+	}
+
+	/*!
+	 * @brief 槽位是否属于调用点
+	 */
+	static bool match(const Slot& slot, const char* where, int type) {
+		return slot.type == type && !strncmp(slot.where, where, GLOG_LIMIT_WHERE - 1);
+	}
+
+	Slot* find(const void* key, const char* where, int type) {
+		uintptr_t h = uintptr_t(key);
+		for (size_t i = 0; i < GLOG_LIMIT_WHERE - 1 && where[i]; ++i)	// 位置与类型参与散列
+			h = (h ^ (unsigned char) where[i]) * 0x100000001B3ULL;
+		h ^= uintptr_t(type);
+		h ^= h >> 17;
+		h *= 0x9E3779B97F4A7C15ULL;
+		h >>= 32;
+		for (int i = 0; i < GLOG_LIMIT_SLOTS; ++i) {
+			Slot& slot = slots_[(h + i) & (GLOG_LIMIT_SLOTS - 1)];
+			const void* k = slot.key.load(std::memory_order_acquire);
+			if (!k && slot.key.compare_exchange_strong(k, claim(), std::memory_order_acquire)) {
+				strncpy(slot.where, where, sizeof(slot.where) - 1);
+				slot.where[sizeof(slot.where) - 1] = 0;
+				slot.type = type;
+				slot.key.store(key, std::memory_order_release);
+				return &slot;
+			}
+			while (k == claim()) {// 其它线程正在写入此槽位
+				std::this_thread::yield();
+				k = slot.key.load(std::memory_order_acquire);
+			}
+			if (k == key && match(slot, where, type)) return &slot;
+		}
+		return NULL;
+	}
+};
+
+#endif /* SRC_GLOGLIMITER_H_ */
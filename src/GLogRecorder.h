@@ -0,0 +1,237 @@
+/**
+ * @file GLogRecorder.h 日志飞行记录器: 内存映射文件中的环形缓冲区, 保存最近的日志
+ * @version 0.1
+ * @date 2026-10-16
+ * @note
+ * - 文件由固定长度的槽位构成. 写入方以原子计数器取得序号, 序号对槽位数取模得到槽位, 无锁
+ * - 写入槽位前清除其序号, 写完后发布序号. 崩溃时未写完的槽位序号为0, 读取时被忽略
+ * - 映射为MAP_SHARED. 进程崩溃或被SIGKILL终止后, 已写入的数据仍保留在文件中
+ * - 超过槽位负载长度的日志被截断
+ * - 打开已有的记录文件时, 先将其改名为"文件名.prev", 保留上一次运行的记录
+ */
+
+#ifndef SRC_GLOGRECORDER_H_
+#define SRC_GLOGRECORDER_H_
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#define GLOG_REC_MAGIC	"LXMGLR1"	///< 文件标识
+#define GLOG_REC_SLOT	256			///< 槽位长度, 量纲: 字节
+#define GLOG_REC_SIZE	(8 * 1024 * 1024)	///< 缺省文件容量, 量纲: 字节
+
+enum {// 槽位内容
+	GLS_LINE = 1,	///< 完整的文本日志, 含时标
+	GLS_TEXT,		///< 文本日志, 不含时标
+	GLS_ENTRY		///< 二进制日志: "位置\0格式\0" + 参数
+};
+
+/*!
+ * @struct GLogRecorderHead 文件头, 占用一个槽位
+ */
+struct GLogRecorderHead {
+	char magic[8];		///< 文件标识
+	uint32_t slotSize;	///< 槽位长度
+	uint32_t slots;		///< 槽位数量, 不含文件头
+	uint64_t head;		///< 下一个序号, 原子递增
+};
+
+/*!
+ * @struct GLogSlot 槽位头, 其后为负载
+ */
+struct GLogSlot {
+	uint64_t seq;		///< 序号 + 1. 0: 无效
+	int64_t stamp;		///< UTC时刻, 量纲: 纳秒
+	uint16_t len;		///< 负载长度
+	uint8_t kind;		///< 槽位内容
+	uint8_t type;		///< 日志类型
+	uint32_t reserved;
+
+public:
+	const char* payload() const {
+		return (const char*) this + sizeof(GLogSlot);
+	}
+};
+
+#define GLOG_REC_PAYLOAD	(GLOG_REC_SLOT - int(sizeof(GLogSlot)))	///< 槽位负载长度
+
+/*!
+ * @class GLogRecorder 写入飞行记录
+ */
+class GLogRecorder {
+protected:
+	int fd_;			///< 文件描述符
+	char* base_;		///< 映射首地址
+	size_t size_;		///< 映射长度
+	uint32_t slots_;	///< 槽位数量
+
+public:
+	GLogRecorder() {
+		fd_    = -1;
+		base_  = NULL;
+		size_  = 0;
+		slots_ = 0;
+	}
+
+	virtual ~GLogRecorder() {
+		Close();
+	}
+
+	/*!
+	 * @brief 创建记录文件
+	 * @param path   文件路径
+	 * @param bytes  容量, 量纲: 字节
+	 * @return
+	 * 操作结果
+	 */
+	bool Open(const char* path, size_t bytes) {
+		Close();
+		uint32_t slots = uint32_t(bytes / GLOG_REC_SLOT);
+		if (slots < 2) slots = 2;
+		size_t size = size_t(slots + 1) * GLOG_REC_SLOT;
+
+		if (!access(path, F_OK)) rename(path, (std::string(path) + ".prev").c_str());
+		if ((fd_ = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644)) < 0
+				|| ftruncate(fd_, off_t(size))
+				|| (base_ = (char*) mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0)) == MAP_FAILED) {
+			base_ = NULL;
+			Close();
+			return false;
+		}
+		GLogRecorderHead* head = (GLogRecorderHead*) base_;
+		head->slotSize = GLOG_REC_SLOT;
+		head->slots    = slots;
+		head->head     = 0;
+		memcpy(head->magic, GLOG_REC_MAGIC, sizeof(head->magic));
+		size_  = size;
+		slots_ = slots;
+		return true;
+	}
+
+	void Close() {
+		if (base_) {
+			munmap(base_, size_);
+			base_ = NULL;
+		}
+		if (fd_ >= 0) {
+			close(fd_);
+			fd_ = -1;
+		}
+		size_ = slots_ = 0;
+	}
+
+	bool IsOpen() const {
+		return base_ != NULL;
+	}
+
+	/*!
+	 * @brief 记录一条日志. 可由多个线程同时调用
+	 * @param stamp  UTC时刻, 量纲: 纳秒
+	 * @param kind   槽位内容
+	 * @param type   日志类型
+	 * @param parts  负载分段
+	 * @param n      分段数量
+	 */
+	void Append(int64_t stamp, int kind, int type, const struct iovec* parts, int n) {
+		GLogRecorderHead* head = (GLogRecorderHead*) base_;
+		uint64_t seq = __atomic_fetch_add(&head->head, 1, __ATOMIC_RELAXED);
+		GLogSlot* slot = (GLogSlot*) (base_ + (seq % slots_ + 1) * GLOG_REC_SLOT);
+		char* payload = (char*) slot + sizeof(GLogSlot);
+		size_t len(0), m;
+
+		__atomic_store_n(&slot->seq, 0, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+		for (int i = 0; i < n && len < size_t(GLOG_REC_PAYLOAD); ++i) {
+			m = std::min(parts[i].iov_len, size_t(GLOG_REC_PAYLOAD) - len);
+			memcpy(payload + len, parts[i].iov_base, m);
+			len += m;
+		}
+		slot->stamp = stamp;
+		slot->len   = uint16_t(len);
+		slot->kind  = uint8_t(kind);
+		slot->type  = uint8_t(type);
+		__atomic_store_n(&slot->seq, seq + 1, __ATOMIC_RELEASE);
+	}
+};
+
+/*!
+ * @class GLogRecorderReader 读取飞行记录, 可用于正在写入或已崩溃进程的记录文件
+ */
+class GLogRecorderReader {
+protected:
+	int fd_;			///< 文件描述符
+	char* base_;		///< 映射首地址
+	size_t size_;		///< 映射长度
+
+public:
+	GLogRecorderReader() {
+		fd_   = -1;
+		base_ = NULL;
+		size_ = 0;
+	}
+
+	virtual ~GLogRecorderReader() {
+		Close();
+	}
+
+	bool Open(const char* path) {
+		struct stat st;
+
+		Close();
+		if ((fd_ = open(path, O_RDONLY)) < 0 || fstat(fd_, &st)
+				|| size_t(st.st_size) < sizeof(GLogRecorderHead)
+				|| (base_ = (char*) mmap(NULL, size_t(st.st_size), PROT_READ, MAP_SHARED, fd_, 0)) == MAP_FAILED) {
+			base_ = NULL;
+			Close();
+			return false;
+		}
+		size_ = size_t(st.st_size);
+		const GLogRecorderHead* head = (const GLogRecorderHead*) base_;
+		if (memcmp(head->magic, GLOG_REC_MAGIC, sizeof(head->magic)) || head->slotSize != GLOG_REC_SLOT
+				|| size_t(head->slots + 1) * GLOG_REC_SLOT > size_) {
+			Close();
+			return false;
+		}
+		return true;
+	}
+
+	void Close() {
+		if (base_) {
+			munmap(base_, size_);
+			base_ = NULL;
+		}
+		if (fd_ >= 0) {
+			close(fd_);
+			fd_ = -1;
+		}
+		size_ = 0;
+	}
+
+	/*!
+	 * @brief 按序号排列的有效槽位. 槽位直接指向映射区, 在Close()之前有效
+	 */
+	void Collect(std::vector<const GLogSlot*>& slots) const {
+		slots.clear();
+		if (!base_) return;
+		const GLogRecorderHead* head = (const GLogRecorderHead*) base_;
+		for (uint32_t i = 1; i <= head->slots; ++i) {
+			const GLogSlot* slot = (const GLogSlot*) (base_ + size_t(i) * GLOG_REC_SLOT);
+			if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) && slot->len <= GLOG_REC_PAYLOAD)
+				slots.push_back(slot);
+		}
+		std::sort(slots.begin(), slots.end(), [](const GLogSlot* a, const GLogSlot* b) {
+			return a->seq < b->seq;
+		});
+	}
+};
+
+#endif /* SRC_GLOGRECORDER_H_ */
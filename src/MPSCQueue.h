@@ -0,0 +1,123 @@
+/**
+ * @file MPSCQueue.h 有界无锁队列, 多生产者/单消费者
+ * @version 0.1
+ * @date 2026-10-16
+ * @note
+ * - 基于序号的环形数组(D. Vyukov有界队列). 生产者以CAS竞争写入位置, 消费者独占读出位置
+ * - 容量取不小于指定值的2的幂
+ * - push()/pop()均不阻塞. 阻塞与唤醒由调用者实现
+ * - emplace()在队列存储区内直接构建元素, 避免大元素的拷贝
+ */
+
+#ifndef SRC_MPSCQUEUE_H_
+#define SRC_MPSCQUEUE_H_
+
+#include <atomic>
+#include <stddef.h>
+#include <memory>
+
+template<typename T>
+class MPSCQueue {
+protected:
+	struct Cell {
+		std::atomic<size_t> seq;	///< 序号: ==pos可写入, ==pos+1可读出
+		T data;
+	};
+
+	std::unique_ptr<Cell[]> cells_;	///< 环形数组
+	size_t mask_;		///< 容量-1
+	char pad0_[64];
+	std::atomic<size_t> tail_;	///< 写入位置, 生产者共享
+	char pad1_[64];
+	std::atomic<size_t> head_;	///< 读出位置, 消费者独占
+	char pad2_[64];
+
+public:
+	MPSCQueue(size_t capacity = 1024) {
+		size_t n(2);
+		while (n < capacity) n <<= 1;
+		mask_ = n - 1;
+		cells_.reset(new Cell[n]);
+		for (size_t i = 0; i < n; ++i)
+			cells_[i].seq.store(i, std::memory_order_relaxed);
+		tail_.store(0, std::memory_order_relaxed);
+		head_.store(0, std::memory_order_relaxed);
+	}
+
+	size_t capacity() const {
+		return mask_ + 1;
+	}
+
+	/*!
+	 * @brief 写入. 可由多个线程同时调用
+	 * @return
+	 * 写入结果. 队列满时返回false
+	 */
+	bool push(const T& x) {
+		return emplace([&x](T& data) { data = x; });
+	}
+
+	/*!
+	 * @brief 在队列存储区内写入. 可由多个线程同时调用
+	 * @param fill 形式为fill(T&), 写入元素
+	 * @return
+	 * 写入结果. 队列满时返回false, 不调用fill
+	 */
+	template<typename Fill>
+	bool emplace(Fill fill) {
+		size_t pos = tail_.load(std::memory_order_relaxed);
+		Cell* cell;
+
+		while (true) {
+			cell = &cells_[pos & mask_];
+			size_t seq = cell->seq.load(std::memory_order_acquire);
+			long diff = long(seq) - long(pos);
+			if (diff == 0) {
+				if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0) return false;
+			else pos = tail_.load(std::memory_order_relaxed);
+		}
+		fill(cell->data);
+		cell->seq.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	/*!
+	 * @brief 读出. 仅由消费者线程调用
+	 * @return
+	 * 读出结果. 队列空时返回false
+	 */
+	bool pop(T& x) {
+		size_t head = head_.load(std::memory_order_relaxed);
+		Cell* cell = &cells_[head & mask_];
+		if (cell->seq.load(std::memory_order_acquire) != head + 1) return false;
+		x = cell->data;
+		cell->seq.store(head + mask_ + 1, std::memory_order_release);
+		head_.store(head + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+	/*!
+	 * @brief 查看队首元素, 不读出. 仅由消费者线程调用
+	 * @return
+	 * 队首元素地址. 队列空时返回NULL
+	 */
+	T* front() {
+		size_t head = head_.load(std::memory_order_relaxed);
+		Cell* cell = &cells_[head & mask_];
+		return cell->seq.load(std::memory_order_acquire) == head + 1 ? &cell->data : NULL;
+	}
+
+	/*!
+	 * @brief 估计队列中的元素数量
+	 */
+	size_t size_approx() const {
+		size_t tail = tail_.load(std::memory_order_relaxed);
+		size_t head = head_.load(std::memory_order_relaxed);
+		return tail > head ? tail - head : 0;
+	}
+};
+
+#endif /* SRC_MPSCQUEUE_H_ */
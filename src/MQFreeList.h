@@ -0,0 +1,76 @@
+/**
+ * @file MQFreeList.h 空闲槽位编号栈, 无锁, 多线程可同时存取
+ * @version 0.1
+ * @date 2026-10-16
+ * @note
+ * - 栈顶与版本号合并为64位原子量, 避免ABA问题
+ * - 槽位数据由使用者另行保存, 本类仅管理编号
+ */
+
+#ifndef SRC_MQFREELIST_H_
+#define SRC_MQFREELIST_H_
+
+#include <atomic>
+#include <stdint.h>
+#include <boost/smart_ptr/shared_array.hpp>
+
+class MQFreeList {
+protected:
+	boost::shared_array<std::atomic<uint32_t> > next_;	///< 下一空闲编号+1. 0: 无
+	uint32_t count_;	///< 编号数量
+	std::atomic<uint64_t> head_;	///< 栈顶: 高32位为版本号, 低32位为编号+1
+
+public:
+	MQFreeList(uint32_t count = 0) {
+		count_ = 0;
+		head_.store(0);
+		Reset(count);
+	}
+
+	uint32_t Count() const {
+		return count_;
+	}
+
+	/*!
+	 * @brief 重建空闲栈, 全部编号空闲. 调用者保证无其它线程访问
+	 */
+	void Reset(uint32_t count) {
+		if (count != count_) {
+			count_ = count;
+			next_.reset(count ? new std::atomic<uint32_t>[count] : NULL);
+		}
+		for (uint32_t i = 0; i < count; ++i)
+			next_[i].store(i + 1 < count ? i + 2 : 0, std::memory_order_relaxed);
+		head_.store(count ? 1 : 0);
+	}
+
+	/*!
+	 * @brief 取出空闲编号
+	 * @return
+	 * 编号. 无空闲编号时返回-1
+	 */
+	int Pop() {
+		uint64_t head = head_.load(std::memory_order_acquire), next;
+		uint32_t index;
+
+		do {
+			if (!(index = uint32_t(head))) return -1;
+			next = ((head >> 32) + 1) << 32 | next_[index - 1].load(std::memory_order_relaxed);
+		} while (!head_.compare_exchange_weak(head, next, std::memory_order_acquire));
+		return int(index - 1);
+	}
+
+	/*!
+	 * @brief 归还编号. 此前对槽位数据的修改对下一个取出者可见
+	 */
+	void Push(int index) {
+		uint64_t head = head_.load(std::memory_order_relaxed), next;
+
+		do {
+			next_[index].store(uint32_t(head), std::memory_order_relaxed);
+			next = ((head >> 32) + 1) << 32 | uint32_t(index + 1);
+		} while (!head_.compare_exchange_weak(head, next, std::memory_order_release));
+	}
+};
+
+#endif /* SRC_MQFREELIST_H_ */
@@ -0,0 +1,281 @@
+/**
+ * @file MQJournal.h 消息队列日志: 以内存映射文件记录消息, 供重放与基准测试
+ * @version 0.1
+ * @date 2026-10-16
+ * @note
+ * - 文件格式: 文件头 + 记录序列. 记录长度按8字节对齐, 长度字段最后写入, 0表示文件结束
+ * - 多线程可同时写入: 以原子偏移量预留空间, 写入不加锁
+ * - 文件预先扩展至指定容量, 写满后停止记录并计数. 关闭时截断至实际长度
+ * - 大负载记录其原始字节, 重放时以内部负载形式交付
+ * - 依赖POSIX内存映射. WINDOWS平台不支持记录与重放, Open()返回false
+ */
+
+#ifndef SRC_MQJOURNAL_H_
+#define SRC_MQJOURNAL_H_
+
+#if !defined(WINDOWS)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <atomic>
+#include <string>
+
+#define MQJ_MAGIC	"LXMMQJ1"	///< 文件标识
+
+/*!
+ * @struct MQJournalHead 文件头
+ */
+struct MQJournalHead {
+	char magic[8];		///< 文件标识
+	int64_t start;		///< 起始UTC时刻, 量纲: 纳秒, 相对1970-01-01
+};
+
+/*!
+ * @struct MQJournalRecord 记录头, 其后为负载
+ */
+struct MQJournalRecord {
+	uint32_t length;	///< 记录长度, 含记录头与对齐填充. 0: 无后续记录
+	uint32_t size;		///< 负载长度
+	int64_t stamp;		///< 相对起始时刻, 量纲: 纳秒
+	int64_t id;			///< 消息编号
+	int64_t par1, par2;	///< 参数
+
+public:
+	const char* payload() const {
+		return (const char*) this + sizeof(MQJournalRecord);
+	}
+};
+
+/*!
+ * @class MQJournal 写入日志
+ */
+class MQJournal {
+protected:
+	int fd_;			///< 文件描述符
+	char* base_;		///< 映射首地址
+	size_t capacity_;	///< 文件容量
+	std::atomic<size_t> tail_;		///< 下一条记录的偏移量
+	std::atomic<uint64_t> dropped_;	///< 容量不足未记录的消息数量
+	int64_t start_;		///< 起始单调时钟, 量纲: 纳秒
+	std::string errmsg_;	///< 错误原因
+
+public:
+	MQJournal() {
+		fd_   = -1;
+		base_ = NULL;
+		capacity_ = 0;
+		tail_     = 0;
+		dropped_  = 0;
+		start_    = 0;
+	}
+
+	virtual ~MQJournal() {
+		Close();
+	}
+
+	/*!
+	 * @brief 创建日志文件
+	 * @param path     文件路径. 已存在时覆盖
+	 * @param capacity 容量, 量纲: 字节
+	 * @param utc      起始UTC时刻, 量纲: 纳秒
+	 * @param steady   起始单调时钟, 量纲: 纳秒. 记录时刻以此为零点
+	 * @return
+	 * 操作结果
+	 */
+	bool Open(const char* path, size_t capacity, int64_t utc, int64_t steady) {
+		Close();
+		capacity = (capacity + 7) & ~size_t(7);
+		if (capacity < sizeof(MQJournalHead) + sizeof(MQJournalRecord)) {
+			errmsg_ = "journal capacity is too small";
+			return false;
+		}
+#if defined(WINDOWS)
+		(void) path;
+		(void) utc;
+		(void) steady;
+		errmsg_ = "journal is not supported on this platform";
+		return false;
+#else
+		if ((fd_ = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644)) < 0
+				|| ftruncate(fd_, off_t(capacity))
+				|| (base_ = (char*) mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0)) == MAP_FAILED) {
+			errmsg_ = strerror(errno);
+			base_ = NULL;
+			Close();
+			return false;
+		}
+
+		MQJournalHead* head = (MQJournalHead*) base_;
+		memcpy(head->magic, MQJ_MAGIC, sizeof(head->magic));
+		head->start = utc;
+		capacity_ = capacity;
+		start_    = steady;
+		tail_     = sizeof(MQJournalHead);
+		dropped_  = 0;
+		return true;
+#endif
+	}
+
+	/*!
+	 * @brief 关闭日志文件, 截断至实际长度
+	 */
+	void Close() {
+#if !defined(WINDOWS)
+		if (base_) {
+			size_t used = tail_.load();
+			if (used > capacity_) used = capacity_;
+			munmap(base_, capacity_);
+			base_ = NULL;
+			if (ftruncate(fd_, off_t(used))) {}
+		}
+		if (fd_ >= 0) {
+			close(fd_);
+			fd_ = -1;
+		}
+#endif
+	}
+
+	bool IsOpen() const {
+		return base_ != NULL;
+	}
+
+	uint64_t GetDropped() const {
+		return dropped_.load();
+	}
+
+	const char* GetError() const {
+		return errmsg_.c_str();
+	}
+
+	/*!
+	 * @brief 记录一条消息. 可由多个线程同时调用
+	 * @param stamp 单调时钟, 量纲: 纳秒
+	 * @param id    消息编号
+	 * @param par1  参数1
+	 * @param par2  参数2
+	 * @param data  负载
+	 * @param size  负载长度
+	 * @return
+	 * 容量不足时返回false
+	 */
+	bool Append(int64_t stamp, long id, long par1, long par2, const void* data, uint32_t size) {
+		size_t length = (sizeof(MQJournalRecord) + size + 7) & ~size_t(7);
+		size_t offset = tail_.fetch_add(length, std::memory_order_relaxed);
+		if (offset + length > capacity_) {
+			dropped_.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		MQJournalRecord* rec = (MQJournalRecord*) (base_ + offset);
+		rec->size  = size;
+		rec->stamp = stamp - start_;
+		rec->id    = id;
+		rec->par1  = par1;
+		rec->par2  = par2;
+		if (size) memcpy(base_ + offset + sizeof(MQJournalRecord), data, size);
+		__atomic_store_n(&rec->length, uint32_t(length), __ATOMIC_RELEASE);
+		return true;
+	}
+};
+
+/*!
+ * @class MQJournalReader 读取日志
+ */
+class MQJournalReader {
+protected:
+	int fd_;			///< 文件描述符
+	char* base_;		///< 映射首地址
+	size_t size_;		///< 文件长度
+	size_t offset_;		///< 下一条记录的偏移量
+
+public:
+	MQJournalReader() {
+		fd_     = -1;
+		base_   = NULL;
+		size_   = 0;
+		offset_ = 0;
+	}
+
+	virtual ~MQJournalReader() {
+		Close();
+	}
+
+	/*!
+	 * @brief 打开日志文件
+	 * @return
+	 * 文件不存在或格式错误时返回false
+	 */
+	bool Open(const char* path) {
+		Close();
+#if defined(WINDOWS)
+		(void) path;
+		return false;
+#else
+		struct stat st;
+
+		if ((fd_ = open(path, O_RDONLY)) < 0 || fstat(fd_, &st)
+				|| size_t(st.st_size) < sizeof(MQJournalHead)
+				|| (base_ = (char*) mmap(NULL, size_t(st.st_size), PROT_READ, MAP_SHARED, fd_, 0)) == MAP_FAILED) {
+			base_ = NULL;
+			Close();
+			return false;
+		}
+		size_ = size_t(st.st_size);
+		if (memcmp(base_, MQJ_MAGIC, sizeof(((MQJournalHead*) 0)->magic))) {
+			Close();
+			return false;
+		}
+		offset_ = sizeof(MQJournalHead);
+		return true;
+#endif
+	}
+
+	void Close() {
+#if !defined(WINDOWS)
+		if (base_) {
+			munmap(base_, size_);
+			base_ = NULL;
+		}
+		if (fd_ >= 0) {
+			close(fd_);
+			fd_ = -1;
+		}
+#endif
+		size_ = offset_ = 0;
+	}
+
+	/*!
+	 * @brief 起始UTC时刻, 量纲: 纳秒
+	 */
+	int64_t Start() const {
+		return base_ ? ((const MQJournalHead*) base_)->start : 0;
+	}
+
+	/*!
+	 * @brief 回到第一条记录
+	 */
+	void Rewind() {
+		if (base_) offset_ = sizeof(MQJournalHead);
+	}
+
+	/*!
+	 * @brief 读出下一条记录. 记录直接指向映射区, 在Close()之前有效
+	 * @return
+	 * 记录地址. 无后续记录时返回NULL
+	 */
+	const MQJournalRecord* Next() {
+		if (!base_ || offset_ + sizeof(MQJournalRecord) > size_) return NULL;
+		const MQJournalRecord* rec = (const MQJournalRecord*) (base_ + offset_);
+		uint32_t length = __atomic_load_n(&rec->length, __ATOMIC_ACQUIRE);
+		if (!length || offset_ + length > size_ || sizeof(MQJournalRecord) + rec->size > length) return NULL;
+		offset_ += length;
+		return rec;
+	}
+};
+
+#endif /* SRC_MQJOURNAL_H_ */
@@ -0,0 +1,111 @@
+/**
+ * @file MQPayload.h 消息队列负载: 回调函数使用的负载视图和大负载句柄池
+ * @version 0.1
+ * @date 2026-10-16
+ * @note
+ * - 小负载直接拷贝至消息内部存储区, 大负载以引用计数句柄传递, 不拷贝数据
+ * - 句柄保存在预分配的槽位中, 消息仅记录槽位编号. 投递与响应均不申请堆内存
+ * - 句柄仅在进程内有效
+ */
+
+#ifndef SRC_MQPAYLOAD_H_
+#define SRC_MQPAYLOAD_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <boost/smart_ptr/shared_ptr.hpp>
+#include <boost/smart_ptr/shared_array.hpp>
+#include "MQFreeList.h"
+
+using MQPayloadPtr = boost::shared_ptr<const void>;	///< 大负载句柄
+
+/*!
+ * @struct MQPayload 消息负载视图
+ * @note
+ * 仅在回调函数内有效. 需在回调函数外继续使用大负载时调用Share()
+ */
+struct MQPayload {
+	const void* data;	///< 负载首地址. 无负载时为NULL
+	size_t size;		///< 负载长度, 量纲: 字节
+	const MQPayloadPtr* handle;	///< 大负载句柄. 内部存储的小负载为NULL
+
+public:
+	MQPayload() {
+		data   = NULL;
+		size   = 0;
+		handle = NULL;
+	}
+
+	bool empty() const {
+		return size == 0;
+	}
+
+	/*!
+	 * @brief 以类型T查看负载. 负载长度不足时返回NULL
+	 */
+	template<typename T> const T* as() const {
+		return size >= sizeof(T) ? static_cast<const T*>(data) : NULL;
+	}
+
+	/*!
+	 * @brief 共享大负载句柄, 延长其生命周期. 内部存储的小负载返回空指针
+	 */
+	MQPayloadPtr Share() const {
+		return handle ? *handle : MQPayloadPtr();
+	}
+};
+
+/*!
+ * @class MQHandlePool 大负载句柄槽位池
+ * @note
+ * 槽位编号由消息携带, 响应完成后归还
+ */
+class MQHandlePool {
+protected:
+	boost::shared_array<MQPayloadPtr> slots_;	///< 槽位
+	MQFreeList free_;	///< 空闲槽位
+
+public:
+	MQHandlePool(uint32_t count = 0) {
+		Reset(count);
+	}
+
+	/*!
+	 * @brief 重建槽位池. 调用者保证无其它线程访问
+	 */
+	void Reset(uint32_t count) {
+		if (count != free_.Count()) slots_.reset(count ? new MQPayloadPtr[count] : NULL);
+		else {
+			for (uint32_t i = 0; i < count; ++i) slots_[i].reset();
+		}
+		free_.Reset(count);
+	}
+
+	/*!
+	 * @brief 占用空闲槽位并保存句柄
+	 * @return
+	 * 槽位编号. 无空闲槽位时返回-1
+	 */
+	int Acquire(const MQPayloadPtr& ptr) {
+		int index = free_.Pop();
+		if (index >= 0) slots_[index] = ptr;
+		return index;
+	}
+
+	/*!
+	 * @brief 查看槽位中的句柄
+	 */
+	const MQPayloadPtr& Get(int index) const {
+		return slots_[index];
+	}
+
+	/*!
+	 * @brief 释放句柄并归还槽位
+	 */
+	void Release(int index) {
+		slots_[index].reset();
+		free_.Push(index);
+	}
+};
+
+#endif /* SRC_MQPAYLOAD_H_ */
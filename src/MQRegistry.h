@@ -0,0 +1,131 @@
+/**
+ * @file MQRegistry.h 消息编号与响应函数的注册表, 开放寻址哈希表
+ * @version 0.1
+ * @date 2026-10-16
+ * @note
+ * - 消息编号可稀疏分布, 注册表按需扩容
+ * - 查找不加锁, 不申请内存. 注册与扩容以互斥锁串行化
+ * - 表项创建后地址不变, 注销仅清除其响应函数. 扩容时旧表保留至注册表销毁,
+ *   正在查找的线程无需引用计数
+ */
+
+#ifndef SRC_MQREGISTRY_H_
+#define SRC_MQREGISTRY_H_
+
+#include <atomic>
+#include <vector>
+#include <stdint.h>
+#include <boost/smart_ptr/shared_ptr.hpp>
+#include <boost/smart_ptr/shared_array.hpp>
+#include <boost/thread/mutex.hpp>
+
+/*!
+ * @class MQRegistry 注册表
+ * @note
+ * Entry需提供成员变量id及构造函数Entry(long id)
+ */
+template<typename Entry>
+class MQRegistry {
+protected:
+	using EntryPtr = boost::shared_ptr<Entry>;
+	using MtxLck = boost::unique_lock<boost::mutex>;
+
+	struct Table {
+		int bits;		///< 槽位数=2^bits
+		boost::shared_array<std::atomic<Entry*> > slots;	///< 槽位. NULL: 空闲
+	};
+	using TablePtr = boost::shared_ptr<Table>;
+
+	std::atomic<Table*> table_;		///< 当前表
+	std::vector<TablePtr> tables_;	///< 当前表和已被替换的旧表
+	std::vector<EntryPtr> entries_;	///< 全部表项
+	boost::mutex mtx_;	///< 互斥锁: 注册与扩容
+
+public:
+	MQRegistry() {
+		table_.store(create_table(6));
+	}
+
+	/*!
+	 * @brief 查找表项. 可与Insert()同时调用
+	 * @return
+	 * 表项地址. 未注册时返回NULL
+	 */
+	Entry* Find(long id) const {
+		const Table* table = table_.load(std::memory_order_acquire);
+		size_t mask = (size_t(1) << table->bits) - 1;
+		Entry* entry;
+
+		for (size_t i = hash(id, table->bits); ; i = (i + 1) & mask) {
+			if (!(entry = table->slots[i].load(std::memory_order_acquire))) return NULL;
+			if (entry->id == id) return entry;
+		}
+	}
+
+	/*!
+	 * @brief 查找表项, 未注册时创建
+	 * @return
+	 * 表项地址. 在注册表生命周期内有效
+	 */
+	Entry* Insert(long id) {
+		MtxLck lck(mtx_);
+		Entry* entry = Find(id);
+		if (entry) return entry;
+
+		Table* table = table_.load(std::memory_order_relaxed);
+		if ((entries_.size() + 1) * 2 > (size_t(1) << table->bits)) {// 装填因子不超过0.5
+			Table* larger = create_table(table->bits + 1);
+			for (size_t i = 0; i < entries_.size(); ++i) put(larger, entries_[i].get());
+			table_.store(table = larger, std::memory_order_release);
+		}
+		entries_.push_back(EntryPtr(new Entry(id)));
+		entry = entries_.back().get();
+		put(table, entry);
+		return entry;
+	}
+
+	/*!
+	 * @brief 按注册顺序遍历表项
+	 * @param func 形式为func(Entry&)
+	 */
+	template<typename Func>
+	void ForEach(Func func) {
+		MtxLck lck(mtx_);
+		for (size_t i = 0; i < entries_.size(); ++i) func(*entries_[i]);
+	}
+
+	/*!
+	 * @brief 已注册表项数量
+	 */
+	size_t Size() {
+		MtxLck lck(mtx_);
+		return entries_.size();
+	}
+
+protected:
+	static size_t hash(long id, int bits) {
+		return size_t((uint64_t(id) * 0x9E3779B97F4A7C15ULL) >> (64 - bits));
+	}
+
+	Table* create_table(int bits) {
+		TablePtr table(new Table);
+		size_t n = size_t(1) << bits;
+		table->bits = bits;
+		table->slots.reset(new std::atomic<Entry*>[n]);
+		for (size_t i = 0; i < n; ++i) table->slots[i].store(NULL, std::memory_order_relaxed);
+		tables_.push_back(table);
+		return table.get();
+	}
+
+	/*!
+	 * @brief 写入槽位. 发布槽位前表项已完成构造
+	 */
+	static void put(Table* table, Entry* entry) {
+		size_t mask = (size_t(1) << table->bits) - 1;
+		size_t i = hash(entry->id, table->bits);
+		while (table->slots[i].load(std::memory_order_relaxed)) i = (i + 1) & mask;
+		table->slots[i].store(entry, std::memory_order_release);
+	}
+};
+
+#endif /* SRC_MQREGISTRY_H_ */
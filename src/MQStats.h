@@ -0,0 +1,131 @@
+/**
+ * @file MQStats.h 消息队列统计: 对数-线性分桶直方图和单个消息编号的计数器
+ * @version 0.1
+ * @date 2026-10-16
+ * @note
+ * - 直方图按HDR方式分桶: 以2的幂划分主区间, 每个主区间再等分16个子区间, 相对误差不超过6.25%
+ * - 记录值量纲为纳秒, 上限为2^(MAX_BITS+1)-1纳秒(约36分钟), 超出时计入最后一个分桶
+ * - 记录与读取均不加锁. 读取结果为近似快照
+ */
+
+#ifndef SRC_MQSTATS_H_
+#define SRC_MQSTATS_H_
+
+#include <atomic>
+#include <stdint.h>
+
+class MQHistogram {
+protected:
+	enum {
+		SUB_BITS  = 4,					///< 子区间位数
+		SUB_COUNT = 1 << SUB_BITS,		///< 主区间内子区间数量
+		MAX_BITS  = 40,					///< 最高主区间[2^MAX_BITS, 2^(MAX_BITS+1))的最高位
+		BUCKETS   = (MAX_BITS - SUB_BITS + 2) * SUB_COUNT	///< 线性区间[0, SUB_COUNT)与各主区间的分桶总数
+	};
+
+	std::atomic<uint64_t> buckets_[BUCKETS];	///< 分桶计数
+	std::atomic<uint64_t> count_;	///< 记录数量
+	std::atomic<uint64_t> sum_;		///< 记录值之和
+	std::atomic<uint64_t> max_;		///< 最大记录值
+
+public:
+	MQHistogram() {
+		Reset();
+	}
+
+	void Reset() {
+		for (int i = 0; i < BUCKETS; ++i) buckets_[i].store(0, std::memory_order_relaxed);
+		count_.store(0, std::memory_order_relaxed);
+		sum_.store(0, std::memory_order_relaxed);
+		max_.store(0, std::memory_order_relaxed);
+	}
+
+	/*!
+	 * @brief 记录一个值
+	 * @param v 记录值, 量纲: 纳秒
+	 */
+	void Record(uint64_t v) {
+		buckets_[index(v)].fetch_add(1, std::memory_order_relaxed);
+		count_.fetch_add(1, std::memory_order_relaxed);
+		sum_.fetch_add(v, std::memory_order_relaxed);
+		uint64_t old = max_.load(std::memory_order_relaxed);
+		while (v > old && !max_.compare_exchange_weak(old, v, std::memory_order_relaxed));
+	}
+
+	uint64_t Count() const {
+		return count_.load(std::memory_order_relaxed);
+	}
+
+	uint64_t Max() const {
+		return max_.load(std::memory_order_relaxed);
+	}
+
+	/*!
+	 * @brief 平均值, 量纲: 纳秒
+	 */
+	double Mean() const {
+		uint64_t n = Count();
+		return n ? double(sum_.load(std::memory_order_relaxed)) / n : 0.0;
+	}
+
+	/*!
+	 * @brief 分位数
+	 * @param q 分位, 取值范围[0, 1]
+	 * @return
+	 * 分位数所在分桶的上限, 量纲: 纳秒. 不超过最大记录值
+	 */
+	uint64_t Percentile(double q) const {
+		uint64_t n = Count(), sum(0);
+		if (!n) return 0;
+		uint64_t target = uint64_t(q * n + 0.5);
+		if (target < 1) target = 1;
+
+		for (int i = 0; i < BUCKETS; ++i) {
+			if ((sum += buckets_[i].load(std::memory_order_relaxed)) >= target) {
+				uint64_t v = i + 1 < BUCKETS ? lower(i + 1) - 1 : Max();
+				return v < Max() ? v : Max();
+			}
+		}
+		return Max();
+	}
+
+protected:
+	static int index(uint64_t v) {
+		if (v < SUB_COUNT) return int(v);
+		int bits = 63 - __builtin_clzll(v);
+		if (bits > MAX_BITS) return BUCKETS - 1;
+		return (bits - SUB_BITS + 1) * SUB_COUNT + int((v >> (bits - SUB_BITS)) & (SUB_COUNT - 1));
+	}
+
+	static uint64_t lower(int i) {
+		if (i < SUB_COUNT) return uint64_t(i);
+		int bits = i / SUB_COUNT + SUB_BITS - 1;
+		return uint64_t(SUB_COUNT + i % SUB_COUNT) << (bits - SUB_BITS);
+	}
+};
+
+/*!
+ * @struct MQIdStats 单个消息编号的统计
+ */
+struct MQIdStats {
+	std::atomic<uint64_t> posted;	///< 投递数量
+	std::atomic<uint64_t> handled;	///< 响应数量
+	std::atomic<uint64_t> dropped;	///< 丢弃数量: 被合并替换
+	MQHistogram wait;	///< 排队时间: 投递至开始响应
+	MQHistogram exec;	///< 响应函数执行时间
+
+public:
+	MQIdStats() {
+		Reset();
+	}
+
+	void Reset() {
+		posted.store(0, std::memory_order_relaxed);
+		handled.store(0, std::memory_order_relaxed);
+		dropped.store(0, std::memory_order_relaxed);
+		wait.Reset();
+		exec.Reset();
+	}
+};
+
+#endif /* SRC_MQSTATS_H_ */
@@ -0,0 +1,302 @@
+/**
+ * @file MQTimerWheel.h 分层时间轮, 驱动消息队列的延时与周期消息
+ * @version 0.1
+ * @date 2026-10-16
+ * @note
+ * - 4层, 每层256槽位, 时间刻度1毫秒, 跨度约49天. 超出跨度的定时器在到达跨度末端后重新排入
+ * - 定时器节点预分配, 以"版本号<<32 | 节点编号"作为句柄
+ * - Add()/Cancel()可由任意线程调用, 仅写入请求队列. 时间轮由消息队列线程独占,
+ *   在Poll()中处理请求、推进时间并触发到期定时器
+ * - 请求队列已满时, 其它线程等待消息队列线程处理; 消息队列线程(如在响应函数中)就地处理已排队的请求,
+ *   不等待自身
+ * - 插入、取消均为O(1)
+ */
+
+#ifndef SRC_MQTIMERWHEEL_H_
+#define SRC_MQTIMERWHEEL_H_
+
+#include <stdint.h>
+#include <boost/chrono/chrono.hpp>
+#include <boost/smart_ptr/shared_array.hpp>
+#include <boost/thread/thread.hpp>
+#include "MPSCQueue.h"
+#include "MQFreeList.h"
+
+template<typename T>
+class MQTimerWheel {
+public:
+	using Clock = boost::chrono::steady_clock;
+	static const uint64_t never = uint64_t(-1);	///< 无定时器
+
+protected:
+	enum {
+		WHEEL_BITS  = 8,
+		WHEEL_SIZE  = 1 << WHEEL_BITS,
+		WHEEL_MASK  = WHEEL_SIZE - 1,
+		WHEEL_LEVEL = 4
+	};
+
+	enum {// 请求类型
+		REQ_ADD,
+		REQ_CANCEL
+	};
+
+	struct Node {
+		T data;				///< 到期时交付的数据
+		uint64_t expires;	///< 到期时刻, 量纲: 刻度
+		uint64_t period;	///< 周期. 0: 单次
+		uint32_t gen;		///< 版本号, 节点归还时递增
+		bool active;		///< 已排入时间轮
+		int level, slot;	///< 所在层和槽位
+		int prev, next;		///< 槽位双向链表. -1: 无
+	};
+
+	struct Request {
+		int op;
+		uint64_t handle;
+	};
+
+	boost::shared_array<Node> nodes_;	///< 定时器节点
+	MQFreeList free_;		///< 空闲节点
+	MPSCQueue<Request> requests_;	///< 请求队列
+	int heads_[WHEEL_LEVEL][WHEEL_SIZE];	///< 槽位链表头. -1: 空
+	Clock::time_point base_;	///< 刻度0对应的时刻
+	uint64_t now_;		///< 下一个待处理的刻度
+	uint32_t pending_;	///< 已排入时间轮的定时器数量
+	int firing_;		///< 正在触发的定时器节点. -1: 无
+
+public:
+	MQTimerWheel(uint32_t capacity = 4096)
+		: requests_(capacity * 2) {
+		nodes_.reset(new Node[capacity]);
+		for (uint32_t i = 0; i < capacity; ++i) {
+			nodes_[i].gen    = 1;
+			nodes_[i].active = false;
+		}
+		free_.Reset(capacity);
+		for (int l = 0; l < WHEEL_LEVEL; ++l) {
+			for (int i = 0; i < WHEEL_SIZE; ++i) heads_[l][i] = -1;
+		}
+		base_    = Clock::now();
+		now_     = 0;
+		pending_ = 0;
+		firing_  = -1;
+	}
+
+	/*!
+	 * @brief 当前时刻对应的刻度
+	 */
+	uint64_t Tick() const {
+		return tick_of(Clock::now());
+	}
+
+	/*!
+	 * @brief 时刻tm对应的刻度, 向上取整
+	 */
+	uint64_t tick_of(const Clock::time_point& tm) const {
+		if (tm <= base_) return 0;
+		Clock::duration dt = tm - base_;
+		boost::chrono::milliseconds ms = boost::chrono::duration_cast<boost::chrono::milliseconds>(dt);
+		return uint64_t(ms.count()) + (ms < dt ? 1 : 0);
+	}
+
+	/*!
+	 * @brief 刻度tick对应的时刻
+	 */
+	Clock::time_point time_of(uint64_t tick) const {
+		return base_ + boost::chrono::milliseconds(tick);
+	}
+
+	/*!
+	 * @brief 添加定时器. 可由任意线程调用
+	 * @param data    到期时交付的数据
+	 * @param expires 到期刻度
+	 * @param period  周期, 量纲: 刻度. 0: 单次
+	 * @return
+	 * 定时器句柄. 节点耗尽时返回0
+	 */
+	uint64_t Add(const T& data, uint64_t expires, uint64_t period) {
+		int index = free_.Pop();
+		if (index < 0 && poller() == this) {// 消息队列线程: 处理已排队的取消请求后重试
+			drain();
+			index = free_.Pop();
+		}
+		if (index < 0) return 0;
+
+		Node& node = nodes_[index];
+		node.data    = data;
+		node.expires = expires;
+		node.period  = period;
+		uint64_t handle = uint64_t(node.gen) << 32 | uint32_t(index);
+		request(REQ_ADD, handle);
+		return handle;
+	}
+
+	/*!
+	 * @brief 取消定时器. 可由任意线程调用. 已到期或已取消的单次定时器被忽略
+	 */
+	void Cancel(uint64_t handle) {
+		if (handle && uint32_t(handle) < free_.Count()) request(REQ_CANCEL, handle);
+	}
+
+	/*!
+	 * @brief 处理请求并触发到期定时器. 仅由消息队列线程调用
+	 * @param fire 到期回调函数, 形式为fire(const T&)
+	 */
+	template<typename Fire>
+	void Poll(Fire& fire) {
+		poller() = this;
+		drain();
+		if (pending_) advance(Tick(), fire);
+	}
+
+	/*!
+	 * @brief 下一次需要调用Poll()的刻度. 无定时器时返回never
+	 * @note
+	 * 返回值不晚于最早到期时刻, 可能早于到期时刻(高层槽位降级)
+	 */
+	uint64_t NextTick() const {
+		if (!pending_) return never;
+
+		uint64_t next = never, tick, first;
+		for (int l = 0; l < WHEEL_LEVEL; ++l) {// 各层槽位的降级/到期时刻: 不早于now_的首个边界起
+			int shift = l * WHEEL_BITS;
+			first = (now_ + (uint64_t(1) << shift) - 1) >> shift;
+			for (int k = 0; k < WHEEL_SIZE; ++k) {
+				tick = (first + k) << shift;
+				if (tick >= next) break;
+				if (heads_[l][(tick >> shift) & WHEEL_MASK] >= 0) {
+					next = tick;
+					break;
+				}
+			}
+		}
+		return next;
+	}
+
+protected:
+	void request(int op, uint64_t handle) {
+		Request req;
+		req.op     = op;
+		req.handle = handle;
+		while (!requests_.push(req)) {
+			if (poller() == this) drain();	// 消息队列线程: 就地处理, 不等待自身
+			else boost::this_thread::yield();
+		}
+	}
+
+	/*!
+	 * @brief 调用Poll()的线程所属的时间轮
+	 */
+	static const MQTimerWheel*& poller() {
+		static thread_local const MQTimerWheel* wheel = NULL;
+		return wheel;
+	}
+
+	/*!
+	 * @brief 处理已排队的请求. 仅由消息队列线程调用
+	 */
+	void drain() {
+		Request req;
+		while (requests_.pop(req)) {
+			if (req.op == REQ_ADD) insert(int(uint32_t(req.handle)));
+			else cancel(req.handle);
+		}
+	}
+
+	void insert(int index) {
+		Node& node = nodes_[index];
+		uint64_t delta = node.expires > now_ ? node.expires - now_ : 0;
+		uint64_t limit = uint64_t(1) << (WHEEL_BITS * WHEEL_LEVEL);
+		uint64_t expires = delta < limit ? now_ + delta : now_ + limit - 1;
+		int level(0);
+
+		while (level < WHEEL_LEVEL - 1 && (delta >> (WHEEL_BITS * (level + 1)))) ++level;
+		node.level = level;
+		node.slot  = int((expires >> (WHEEL_BITS * level)) & WHEEL_MASK);
+
+		int& head = heads_[level][node.slot];
+		node.prev = -1;
+		node.next = head;
+		if (head >= 0) nodes_[head].prev = index;
+		head = index;
+		if (!node.active) {
+			node.active = true;
+			++pending_;
+		}
+	}
+
+	void unlink(int index) {
+		Node& node = nodes_[index];
+		if (node.prev >= 0) nodes_[node.prev].next = node.next;
+		else heads_[node.level][node.slot] = node.next;
+		if (node.next >= 0) nodes_[node.next].prev = node.prev;
+	}
+
+	void release(int index) {
+		Node& node = nodes_[index];
+		node.active = false;
+		++node.gen;
+		--pending_;
+		free_.Push(index);
+	}
+
+	void cancel(uint64_t handle) {
+		int index = int(uint32_t(handle));
+		Node& node = nodes_[index];
+		if (node.gen != uint32_t(handle >> 32) || !node.active) return;
+		if (index == firing_) {// 在自身的到期回调中取消: 已脱离槽位, 由advance()归还
+			firing_ = -1;
+			return;
+		}
+		unlink(index);
+		release(index);
+	}
+
+	/*!
+	 * @brief 将槽位中的定时器重新排入下层
+	 */
+	void cascade(int level, int slot) {
+		int index = heads_[level][slot], next;
+		heads_[level][slot] = -1;
+		for (; index >= 0; index = next) {
+			next = nodes_[index].next;
+			insert(index);
+		}
+	}
+
+	template<typename Fire>
+	void advance(uint64_t target, Fire& fire) {
+		uint64_t next;
+		int index;
+
+		while (pending_ && now_ <= target) {
+			if ((next = NextTick()) > target) {
+				now_ = target + 1;
+				break;
+			}
+			now_ = next;
+			for (int l = 1; l < WHEEL_LEVEL && !(now_ & ((uint64_t(1) << (WHEEL_BITS * l)) - 1)); ++l)
+				cascade(l, int((now_ >> (WHEEL_BITS * l)) & WHEEL_MASK));
+
+			int& head = heads_[0][now_ & WHEEL_MASK];
+			while ((index = head) >= 0) {
+				Node& node = nodes_[index];
+				head = node.next;
+				if (head >= 0) nodes_[head].prev = -1;
+				firing_ = index;
+				fire(node.data);
+				if (node.period && firing_ == index) {
+					node.expires += node.period;
+					if (node.expires <= now_) node.expires = now_ + 1;
+					insert(index);
+				}
+				else release(index);
+				firing_ = -1;
+			}
+			++now_;
+		}
+	}
+};
+
+#endif /* SRC_MQTIMERWHEEL_H_ */
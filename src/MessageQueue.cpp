@@ -7,6 +7,7 @@
  * - 优化
  */
 
+#include <string.h>
 #include <boost/bind/bind.hpp>
 #include "MessageQueue.h"
 #include "GLog.h"
@@ -14,22 +15,45 @@
 using namespace boost::placeholders;
 using namespace boost::interprocess;
 
-MessageQueue::MessageQueue()
-	: szFunc_ (128) {
-	funcs_.reset(new CallbackFunc[szFunc_]);
+#define MQ_CAPACITY		1024	// 消息队列容量
+
+MessageQueue::MessageQueue() {
+	backend_ = MQ_IPC;
+	waiting_ = false;
+	timer_wake_ = false;
+	nworker_  = 0;
+	shardkey_ = SHARD_ID;
+	ncoalesce_ = 0;
+	szbatch_  = MQ_BATCH_SIZE;
+	stats_ = false;
+	unhandled_ = 0;
+	statslog_   = NULL;
+	statstimer_ = 0;
+	journaling_ = false;
 }
 
 MessageQueue::~MessageQueue() {
 }
 
-bool MessageQueue::Start(const char *name) {
+bool MessageQueue::Start(const char *name, const int backend) {
 	if (thrd_msg_.unique()) return true;
 
 	try {
 		// 启动消息队列
-		MQ::remove(name);
-		mqptr_.reset(new MQ(create_only, name, 1024, sizeof(Message)));
+		if ((backend_ = backend) == MQ_INPROC) {
+			lane_high_.reset(new Lane(MQ_CAPACITY));
+			lane_low_.reset(new Lane(MQ_CAPACITY));
+		}
+		else {
+			MQ::remove(name);
+			mqptr_.reset(new MQ(create_only, name, MQ_CAPACITY, sizeof(Message)));
+		}
+		handles_.Reset(MQ_CAPACITY * 2 + 64);
+		timers_.reset(new Timers(MQ_TIMER_CAPACITY));
+		timer_wake_ = false;
+		batch_.reset(new Message[szbatch_]);
 		register_messages();
+		start_workers();
 		thrd_msg_.reset(new boost::thread(boost::bind(&MessageQueue::thread_message, this)));
 
 		return true;
@@ -48,31 +72,359 @@ void MessageQueue::Stop() {
 	}
 }
 
+bool MessageQueue::SetWorkers(const int n, const int key) {
+	if (thrd_msg_.unique()) return false;
+	nworker_  = n > 0 ? n : 0;
+	shardkey_ = key;
+	return true;
+}
+
+bool MessageQueue::GetWorkerStats(const int i, WorkerStats& stats) {
+	if (i < 0 || i >= int(workers_.size())) return false;
+	Worker& worker = *workers_[i];
+	stats.depth    = long(worker.queue.size_approx());
+	stats.maxdepth = worker.maxdepth.load(std::memory_order_relaxed);
+	stats.handled  = worker.handled.load(std::memory_order_relaxed);
+	return true;
+}
+
+bool MessageQueue::SetBatchSize(const int n) {
+	if (thrd_msg_.unique() || n <= 0) return false;
+	szbatch_ = n;
+	return true;
+}
+
+bool MessageQueue::SetCoalescing(const long id, const bool enable) {
+	if (id < MSG_USER) return false;
+	if (registry_.Insert(id)->coalesce.exchange(enable) != enable)
+		ncoalesce_.fetch_add(enable ? 1 : -1);
+	return true;
+}
+
+void MessageQueue::EnableStats(const bool enable) {
+	stats_.store(enable);
+}
+
+bool MessageQueue::GetStats(const long id, MessageStats& stats) {
+	Handler* handler = registry_.Find(id);
+	if (!handler) return false;
+
+	MQIdStats& st = handler->stats;
+	stats.id       = id;
+	stats.posted   = st.posted.load(std::memory_order_relaxed);
+	stats.handled  = st.handled.load(std::memory_order_relaxed);
+	stats.dropped  = st.dropped.load(std::memory_order_relaxed);
+	stats.wait_p50 = st.wait.Percentile(0.50) * 1E-3;
+	stats.wait_p99 = st.wait.Percentile(0.99) * 1E-3;
+	stats.wait_max = st.wait.Max() * 1E-3;
+	stats.exec_p50 = st.exec.Percentile(0.50) * 1E-3;
+	stats.exec_p99 = st.exec.Percentile(0.99) * 1E-3;
+	stats.exec_max = st.exec.Max() * 1E-3;
+	return true;
+}
+
+void MessageQueue::ResetStats() {
+	registry_.ForEach([](Handler& handler) { handler.stats.Reset(); });
+	unhandled_.store(0);
+}
+
+std::string MessageQueue::DumpStats() {
+	std::vector<long> ids;
+	std::string text;
+	MessageStats st;
+	char line[256];
+
+	registry_.ForEach([&ids](Handler& handler) { ids.push_back(handler.id); });
+	for (size_t i = 0; i < ids.size(); ++i) {
+		if (!GetStats(ids[i], st) || (!st.posted && !st.handled)) continue;
+		snprintf(line, sizeof(line), "id=%ld posted=%lu handled=%lu dropped=%lu"
+				" wait(us) p50=%.1f p99=%.1f max=%.1f exec(us) p50=%.1f p99=%.1f max=%.1f\n",
+				st.id, (unsigned long) st.posted, (unsigned long) st.handled, (unsigned long) st.dropped,
+				st.wait_p50, st.wait_p99, st.wait_max, st.exec_p50, st.exec_p99, st.exec_max);
+		text += line;
+	}
+	snprintf(line, sizeof(line), "unhandled=%lu\n", (unsigned long) unhandled_.load());
+	text += line;
+	return text;
+}
+
+void MessageQueue::SetStatsLog(GLog* log, const boost::chrono::milliseconds& period) {
+	if (!is_created()) return;
+	CancelTimer(statstimer_);
+	statstimer_ = 0;
+	statslog_   = log;
+	if (log) statstimer_ = add_timer(Message(MSG_STATS), period.count(), period.count());
+}
+
+bool MessageQueue::StartJournal(const char *path, const size_t capacity) {
+	JournalPtr journal(new MQJournal);
+	int64_t utc = (boost::posix_time::microsec_clock::universal_time()
+			- boost::posix_time::ptime(boost::gregorian::date(1970, 1, 1))).total_microseconds() * 1000;
+
+	StopJournal();
+	if (!journal->Open(path, capacity, utc, Timers::Clock::now().time_since_epoch().count())) {
+		errmsg_ = journal->GetError();
+		return false;
+	}
+	boost::atomic_store(&journal_, journal);
+	journaling_ = true;
+	return true;
+}
+
+uint64_t MessageQueue::StopJournal() {
+	JournalPtr journal = boost::atomic_load(&journal_);
+	journaling_ = false;
+	boost::atomic_store(&journal_, JournalPtr());
+	// 正在写入的线程持有指针, 最后一个引用释放时关闭文件
+	return journal ? journal->GetDropped() : 0;
+}
+
+long MessageQueue::Replay(const char *path, const bool timed, double *elapsed) {
+	MQJournalReader reader;
+	const MQJournalRecord* rec;
+	Message msg;
+	MQPayload payload;
+	Handler* handler;
+	long n(0);
+
+	if (!reader.Open(path)) {
+		errmsg_ = "invalid journal file";
+		return -1;
+	}
+	if (!registry_.Size()) register_messages();
+
+	Timers::Clock::time_point t0 = Timers::Clock::now();
+	while ((rec = reader.Next())) {
+		if (timed) boost::this_thread::sleep_until(t0 + boost::chrono::nanoseconds(rec->stamp));
+		if ((handler = registry_.Find(long(rec->id)))) {
+			msg.id   = long(rec->id);
+			msg.par1 = long(rec->par1);
+			msg.par2 = long(rec->par2);
+			payload.data = rec->size ? rec->payload() : NULL;
+			payload.size = rec->size;
+			invoke(*handler, msg, payload);
+		}
+		++n;
+	}
+	if (elapsed) *elapsed = boost::chrono::duration<double>(Timers::Clock::now() - t0).count();
+	return n;
+}
+
 bool MessageQueue::RegisterMessage(const long id, const CBSlot& slot) {
-	long pos(id - MSG_USER);
-	bool rslt = pos >= 0 && pos < szFunc_;
-	if (rslt) funcs_[pos].connect(slot);
-	return rslt;
+	if (id < MSG_USER) return false;
+	registry_.Insert(id)->func.connect(slot);
+	return true;
 }
 
-void MessageQueue::PostMessage(const long id, const long par1, const long par2) {
-	if (mqptr_.unique()) {
-		Message msg(id, par1, par2);
-		mqptr_->send(&msg, sizeof(Message), 1);
+bool MessageQueue::RegisterPayload(const long id, const PLSlot& slot) {
+	if (id < MSG_USER) return false;
+	registry_.Insert(id)->plfunc.connect(slot);
+	return true;
+}
+
+void MessageQueue::UnregisterMessage(const long id) {
+	Handler* handler = registry_.Find(id);
+	if (handler) {
+		handler->func.disconnect_all_slots();
+		handler->plfunc.disconnect_all_slots();
 	}
 }
 
+void MessageQueue::PostMessage(const long id, const long par1, const long par2) {
+	if (is_created()) send_message(Message(id, par1, par2), false);
+}
+
 void MessageQueue::SendMessage(const long id, const long par1, const long par2) {
-	if (mqptr_.unique()) {
-		Message msg(id, par1, par2);
-		mqptr_->send(&msg, sizeof(Message), 10);
-	}
+	if (is_created()) send_message(Message(id, par1, par2), true);
+}
+
+bool MessageQueue::PostPayload(const long id, const void *data, const int n, const long par1, const long par2) {
+	return send_payload(id, data, n, par1, par2, false);
+}
+
+bool MessageQueue::PostPayload(const long id, const MQPayloadPtr& handle, const int n, const long par1, const long par2) {
+	return send_payload(id, handle, n, par1, par2, false);
+}
+
+bool MessageQueue::SendPayload(const long id, const void *data, const int n, const long par1, const long par2) {
+	return send_payload(id, data, n, par1, par2, true);
+}
+
+bool MessageQueue::SendPayload(const long id, const MQPayloadPtr& handle, const int n, const long par1, const long par2) {
+	return send_payload(id, handle, n, par1, par2, true);
+}
+
+MessageQueue::TimerHandle MessageQueue::PostMessageAfter(const boost::chrono::milliseconds& delay,
+		const long id, const long par1, const long par2) {
+	return add_timer(Message(id, par1, par2), delay.count(), 0);
+}
+
+MessageQueue::TimerHandle MessageQueue::PostMessageAt(const boost::posix_time::ptime& utc,
+		const long id, const long par1, const long par2) {
+	boost::posix_time::time_duration dt = utc - boost::posix_time::microsec_clock::universal_time();
+	return add_timer(Message(id, par1, par2), dt.total_milliseconds(), 0);
+}
+
+MessageQueue::TimerHandle MessageQueue::PostMessageEvery(const boost::chrono::milliseconds& period,
+		const long id, const long par1, const long par2) {
+	if (period.count() <= 0) return 0;
+	return add_timer(Message(id, par1, par2), period.count(), period.count());
+}
+
+void MessageQueue::CancelTimer(const TimerHandle timer) {
+	if (!is_created()) return;
+	timers_->Cancel(timer);
+	if (!timer_wake_.exchange(true)) send_message(Message(MSG_TIMER), true);
 }
 
 const char *MessageQueue::GetError() {
 	return errmsg_.c_str();
 }
 
+bool MessageQueue::is_created() {
+	return backend_ == MQ_INPROC ? lane_high_.unique() : mqptr_.unique();
+}
+
+bool MessageQueue::coalesce(Handler& handler, const Message& msg) {
+	int replaced(-1);
+	bool first;
+
+	while (handler.lock.test_and_set(std::memory_order_acquire)) boost::this_thread::yield();
+	if (shardkey_ == SHARD_PAR1) {// 按参数1分组: 各参数1独立合并
+		std::pair<std::unordered_map<long, Message>::iterator, bool> slot = handler.keyed.insert(
+				std::make_pair(msg.par1, msg));
+		if (!(first = slot.second)) {
+			replaced = slot.first->second.handle;
+			slot.first->second = msg;
+		}
+	}
+	else {
+		if (handler.pending) replaced = handler.latest.handle;
+		first = !handler.pending;
+		handler.latest  = msg;
+		handler.pending = true;
+	}
+	handler.lock.clear(std::memory_order_release);
+
+	if (!first) handler.stats.dropped.fetch_add(1, std::memory_order_relaxed);
+	if (replaced >= 0) handles_.Release(replaced);
+	return first;
+}
+
+void MessageQueue::send_message(const Message& msg, const bool urgent) {
+	const Message* out = &msg;
+	Message marker(msg.id, msg.par1), stamped;	// 标记携带参数1, 按SHARD_PAR1分组时据此取出消息并选择工作线程
+	bool stats = stats_.load(std::memory_order_relaxed);
+
+	if ((ncoalesce_.load(std::memory_order_relaxed) || stats) && msg.id >= MSG_USER) {
+		Handler* handler = registry_.Find(msg.id);
+		if (handler && stats) {
+			handler->stats.posted.fetch_add(1, std::memory_order_relaxed);
+			stamped = msg;
+			stamped.stamp = Timers::Clock::now().time_since_epoch().count();
+			out = &stamped;
+		}
+		if (handler && handler->coalesce.load(std::memory_order_relaxed)) {
+			if (!coalesce(*handler, *out)) return;
+			marker.size = SIZE_COALESCED;
+			out = &marker;
+		}
+	}
+
+	if (backend_ == MQ_IPC) {
+		mqptr_->send(out, sizeof(Message), urgent ? 10 : 1);
+		return;
+	}
+
+	Lane& lane = urgent ? *lane_high_ : *lane_low_;
+	while (!lane.push(*out)) {// 队列已满: 唤醒响应线程后让出CPU
+		{
+			MtxLck lck(mtx_wait_);
+			cv_wait_.notify_one();
+		}
+		boost::this_thread::yield();
+	}
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (waiting_.load(std::memory_order_relaxed)) {
+		MtxLck lck(mtx_wait_);
+		cv_wait_.notify_one();
+	}
+}
+
+MessageQueue::TimerHandle MessageQueue::add_timer(const Message& msg, const int64_t delay, const int64_t period) {
+	if (!is_created()) return 0;
+	TimerHandle timer = timers_->Add(msg, timers_->Tick() + (delay > 0 ? delay : 0), period);
+	if (timer && !timer_wake_.exchange(true)) send_message(Message(MSG_TIMER), true);
+	return timer;
+}
+
+bool MessageQueue::send_payload(const long id, const void *data, const int n,
+		const long par1, const long par2, const bool urgent) {
+	if (n < 0 || n > MQ_PAYLOAD_INLINE || (n && !data) || !is_created()) return false;
+	Message msg(id, par1, par2);
+	if ((msg.size = n)) memcpy(msg.data, data, n);
+	send_message(msg, urgent);
+	return true;
+}
+
+bool MessageQueue::send_payload(const long id, const MQPayloadPtr& handle, const int n,
+		const long par1, const long par2, const bool urgent) {
+	if (!handle || n < 0 || !is_created()) return false;
+	Message msg(id, par1, par2);
+	msg.size = n;
+	// 槽位耗尽时不等待: 调用者可能是响应线程或工作线程, 等待其归还槽位将永不返回
+	if ((msg.handle = handles_.Acquire(handle)) < 0) return false;
+	send_message(msg, urgent);
+	return true;
+}
+
+int MessageQueue::receive_batch(const uint64_t tick) {
+	Message* msgs = batch_.get();
+	int n(0);
+
+	if (!receive_message(msgs[n++], tick)) return 0;
+	if (backend_ == MQ_IPC) {
+		MQ::size_type szrcv;
+		uint32_t priority;
+		while (n < szbatch_ && msgs[n - 1].id != MSG_QUIT
+				&& mqptr_->try_receive(&msgs[n], sizeof(Message), szrcv, priority)) ++n;
+	}
+	else {
+		while (n < szbatch_ && msgs[n - 1].id != MSG_QUIT
+				&& (lane_high_->pop(msgs[n]) || lane_low_->pop(msgs[n]))) ++n;
+	}
+	return n;
+}
+
+bool MessageQueue::receive_message(Message& msg, const uint64_t tick) {
+	if (backend_ == MQ_IPC) {
+		MQ::size_type szrcv;
+		uint32_t priority;
+		if (tick == Timers::never) {
+			mqptr_->receive(&msg, sizeof(Message), szrcv, priority);
+			return true;
+		}
+		Timers::Clock::duration dt = timers_->time_of(tick) - Timers::Clock::now();
+		boost::posix_time::ptime until = boost::posix_time::microsec_clock::universal_time()
+				+ boost::posix_time::microseconds(boost::chrono::duration_cast<boost::chrono::microseconds>(dt).count());
+		return mqptr_->timed_receive(&msg, sizeof(Message), szrcv, priority, until);
+	}
+
+	while (!lane_high_->pop(msg) && !lane_low_->pop(msg)) {
+		MtxLck lck(mtx_wait_);
+		bool timeout(false);
+		waiting_.store(true, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (!lane_high_->front() && !lane_low_->front()) {
+			if (tick == Timers::never) cv_wait_.wait(lck);
+			else timeout = cv_wait_.wait_until(lck, timers_->time_of(tick)) == boost::cv_status::timeout;
+		}
+		waiting_.store(false, std::memory_order_relaxed);
+		if (timeout) return false;
+	}
+	return true;
+}
+
 void MessageQueue::interrupt_thread(ThreadPtr& thrd) {
 	if (thrd.unique()) {
 		thrd->interrupt();
@@ -81,16 +433,161 @@ void MessageQueue::interrupt_thread(ThreadPtr& thrd) {
 	}
 }
 
-void MessageQueue::thread_message() {
+void MessageQueue::dispatch(const Message& rcvd) {
+	Handler* handler = registry_.Find(rcvd.id);
+	Message latest;
+	const Message& msg = rcvd.size == SIZE_COALESCED && handler ? latest : rcvd;
+
+	if (&msg == &latest) {// 可合并消息: 取出最新参数与负载
+		bool found(true);
+		while (handler->lock.test_and_set(std::memory_order_acquire)) boost::this_thread::yield();
+		if (shardkey_ == SHARD_PAR1) {
+			std::unordered_map<long, Message>::iterator it = handler->keyed.find(rcvd.par1);
+			if ((found = it != handler->keyed.end())) {
+				latest = it->second;
+				handler->keyed.erase(it);
+			}
+		}
+		else {
+			latest = handler->latest;
+			handler->pending = false;
+		}
+		handler->lock.clear(std::memory_order_release);
+		if (!found) return;
+	}
+
+	MQPayload payload;
+	payload.size = msg.size;
+	if (msg.handle >= 0) {
+		payload.handle = &handles_.Get(msg.handle);
+		payload.data   = payload.handle->get();
+	}
+	else if (msg.size) payload.data = msg.data;
+
+	if (journaling_.load(std::memory_order_relaxed) && msg.id >= MSG_USER) {
+		JournalPtr journal = boost::atomic_load(&journal_);
+		if (journal) {
+			int64_t stamp = msg.stamp ? msg.stamp : Timers::Clock::now().time_since_epoch().count();
+			journal->Append(stamp, msg.id, msg.par1, msg.par2, payload.data, uint32_t(payload.size));
+		}
+	}
+
+	if (handler) invoke(*handler, msg, payload);
+	else if (msg.id >= MSG_USER) unhandled_.fetch_add(1, std::memory_order_relaxed);
+	if (msg.handle >= 0) handles_.Release(msg.handle);
+}
+
+void MessageQueue::invoke(Handler& handler, const Message& msg, const MQPayload& payload) {
+	int64_t start(0);
+	if (stats_.load(std::memory_order_relaxed)) {
+		start = Timers::Clock::now().time_since_epoch().count();
+		if (msg.stamp && start > msg.stamp) handler.stats.wait.Record(uint64_t(start - msg.stamp));
+	}
+
+	handler.func(msg.par1, msg.par2);
+	handler.plfunc(msg.par1, msg.par2, payload);
+
+	if (start) {
+		int64_t stop = Timers::Clock::now().time_since_epoch().count();
+		handler.stats.exec.Record(uint64_t(stop > start ? stop - start : 0));
+		handler.stats.handled.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void MessageQueue::route(const Message& msg) {
+	if (workers_.empty()) {
+		dispatch(msg);
+		return;
+	}
+
+	uint64_t key = uint64_t(shardkey_ == SHARD_PAR1 ? msg.par1 : msg.id);
+	Worker& worker = *workers_[((key * 0x9E3779B97F4A7C15ULL) >> 32) % workers_.size()];
+	while (!worker.queue.push(msg)) {// 队列已满: 等待工作线程, 保持同组消息顺序
+		{
+			MtxLck lck(worker.mtx);
+			worker.cv.notify_one();
+		}
+		boost::this_thread::yield();
+	}
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (worker.waiting.load(std::memory_order_relaxed)) {
+		MtxLck lck(worker.mtx);
+		worker.cv.notify_one();
+	}
+
+	long depth = long(worker.queue.size_approx());
+	if (depth > worker.maxdepth.load(std::memory_order_relaxed))
+		worker.maxdepth.store(depth, std::memory_order_relaxed);
+}
+
+void MessageQueue::fire_timer(const Message& msg) {
+	if (msg.id == MSG_STATS) log_stats();
+	else route(msg);
+}
+
+void MessageQueue::log_stats() {
+	GLog* log = statslog_;
+	if (!log) return;
+
+	log->WriteLines("MessageQueue", LOG_NORMAL, DumpStats().c_str());	// 报表各行不受限流约束
+}
+
+void MessageQueue::start_workers() {
+	workers_.clear();
+	for (int i = 0; i < nworker_; ++i) {
+		WorkerPtr worker(new Worker(MQ_CAPACITY));
+		worker->thrd.reset(new boost::thread(boost::bind(&MessageQueue::thread_worker, this, worker.get())));
+		workers_.push_back(worker);
+	}
+}
+
+void MessageQueue::stop_workers() {
+	Message msg(MSG_QUIT);
+	for (WorkerVec::iterator it = workers_.begin(); it != workers_.end(); ++it) {
+		Worker& worker = **it;
+		while (!worker.queue.push(msg)) boost::this_thread::yield();
+		{
+			MtxLck lck(worker.mtx);
+			worker.cv.notify_one();
+		}
+		worker.thrd->join();
+		worker.thrd.reset();
+	}
+}
+
+void MessageQueue::thread_worker(Worker* worker) {
+	Lane& queue = worker->queue;
 	Message msg;
-	MQ::size_type szrcv;
-	MQ::size_type szmsg = sizeof(Message);
-	uint32_t priority;
-	long pos;
+
+	while (true) {
+		while (!queue.pop(msg)) {
+			MtxLck lck(worker->mtx);
+			worker->waiting.store(true, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (!queue.front()) worker->cv.wait(lck);
+			worker->waiting.store(false, std::memory_order_relaxed);
+		}
+		if (msg.id == MSG_QUIT) break;
+		dispatch(msg);
+		worker->handled.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void MessageQueue::thread_message() {
+	Timers& timers = *timers_;
+	boost::function<void (const Message&)> fire = boost::bind(&MessageQueue::fire_timer, this, _1);
+	bool running(true);
+	int n, i;
 
 	do {
-		mqptr_->receive(&msg, szmsg, szrcv, priority);
-		if ((pos = msg.id - MSG_USER) >= 0 && pos < szFunc_)
-			(funcs_[pos])(msg.par1, msg.par2);
-	} while(msg.id != MSG_QUIT);
+		n = receive_batch(timers.NextTick());
+		for (i = 0; i < n && running; ++i) {
+			const Message& msg = batch_[i];
+			if (msg.id == MSG_TIMER) timer_wake_.exchange(false);
+			else if (msg.id == MSG_QUIT) running = false;
+			else route(msg);
+		}
+		timers.Poll(fire);
+	} while(running);
+	stop_workers();
 }
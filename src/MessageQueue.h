@@ -6,6 +6,16 @@
  * @date 2020-10-01
  * - 优化
  * - 面向gtoaes, 将GeneralControl和ObservationSystem的共同特征迁移至此处
+ * @date 2026-10-16
+ * - 消息回调函数改用单目标Callback. 同一消息重复注册时替换已有响应函数
+ * - 可选进程内后端: 两条优先级通道的有界无锁MPSC队列, 避免同进程收发时的共享内存与互斥锁开销
+ * - 消息可携带负载: 小负载拷贝至消息内部, 大负载以引用计数句柄传递. 回调函数接收负载视图
+ * - 回调函数数组改为可扩容的注册表. 消息编号不再限于[MSG_USER, MSG_USER+128), 可随时注册/注销
+ * - 延时消息与周期消息, 由消息响应线程中的分层时间轮驱动, 替代轮询线程
+ * - 可选多工作线程分派: 按消息编号或par1分组, 同组消息保持顺序, 不同组并行响应
+ * - 可合并消息: 尚未响应的同编号消息被新消息替换. 响应线程每次唤醒后批量读出消息
+ * - 可选统计: 各消息编号的投递/响应/丢弃数量, 排队时间和响应时间直方图. 可定时写入日志
+ * - 可选记录: 响应的消息写入内存映射文件. Replay()按原始节奏或全速重放, 用于复现与基准测试
  */
 
 #ifndef SRC_MESSAGEQUEUE_H_
@@ -13,51 +23,177 @@
 
 #include <boost/interprocess/ipc/message_queue.hpp>
 #include <boost/thread/thread.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include <boost/smart_ptr.hpp>
-#include <boost/signals2.hpp>
+#include <boost/chrono/chrono.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <atomic>
 #include <string>
+#include <unordered_map>
+#include <vector>
+#include "Callback.h"
+#include "MPSCQueue.h"
+#include "MQPayload.h"
+#include "MQRegistry.h"
+#include "MQTimerWheel.h"
+#include "MQStats.h"
+#include "MQJournal.h"
+#include "GLog.h"
+
+#define MQ_PAYLOAD_INLINE	40	///< 消息内部负载存储区长度, 量纲: 字节
+#define MQ_TIMER_CAPACITY	4096	///< 定时器数量上限
+#define MQ_BATCH_SIZE		32		///< 缺省批量读出消息数量
+#define MQ_JOURNAL_SIZE		(64 * 1024 * 1024)	///< 缺省记录文件容量, 量纲: 字节
 
 class MessageQueue {
+public:
+	enum {// 消息队列后端
+		MQ_IPC,		///< boost::interprocess::message_queue, 可跨进程
+		MQ_INPROC	///< 进程内无锁队列, 收发双方位于同一进程
+	};
+	using TimerHandle = uint64_t;	///< 定时器句柄. 0: 无效
+
+	enum {// 多工作线程分派时的分组依据
+		SHARD_ID,	///< 消息编号
+		SHARD_PAR1	///< 参数1, 例如设备编号
+	};
+
+	struct MessageStats {// 消息统计. 时间量纲: 微秒
+		long id;			///< 消息编号
+		uint64_t posted;	///< 投递数量
+		uint64_t handled;	///< 响应数量
+		uint64_t dropped;	///< 丢弃数量: 被合并替换
+		double wait_p50, wait_p99, wait_max;	///< 排队时间
+		double exec_p50, exec_p99, exec_max;	///< 响应时间
+	};
+
+	struct WorkerStats {// 工作线程统计
+		long depth;		///< 当前队列深度
+		long maxdepth;	///< 最大队列深度
+		long handled;	///< 已响应消息数量
+	};
+
 protected:
 	/* 数据类型 */
 	struct Message {
 		long id;			// 消息编号
 		long par1, par2;	// 参数
+		int size;			// 负载长度. SIZE_COALESCED: 可合并消息的标记
+		int handle;			// 大负载句柄槽位. -1: 负载存储在data中
+		int64_t stamp;		// 投递时刻, 量纲: 纳秒. 0: 未记录
+		char data[MQ_PAYLOAD_INLINE];	// 小负载
 
 	public:
 		Message() {
 			id = par1 = par2 = 0;
+			size = 0;
+			handle = -1;
+			stamp = 0;
 		}
 
 		Message(long _id, long _par1 = 0, long _par2 = 0) {
 			id   = _id;
 			par1 = _par1;
 			par2 = _par2;
+			size = 0;
+			handle = -1;
+			stamp = 0;
 		}
 	};
 
 	//////////////////////////////////////////////////////////////////////////////
-	using CallbackFunc = boost::signals2::signal<void (const long, const long)>;	///< 消息回调函数
+	using CallbackFunc = Callback<void (const long, const long)>;	///< 消息回调函数
 	using CBSlot = CallbackFunc::slot_type;	///< 回调函数插槽
-	using CBArray = boost::shared_array<CallbackFunc>;	///< 回调函数数组
+	using PayloadFunc = Callback<void (const long, const long, const MQPayload&)>;	///< 负载消息回调函数
+	using PLSlot = PayloadFunc::slot_type;	///< 负载消息回调函数插槽
+
+	struct Handler {// 消息响应函数
+		long id;			// 消息编号
+		CallbackFunc func;	// 回调函数
+		PayloadFunc plfunc;	// 负载消息回调函数
+		std::atomic<bool> coalesce;	// 可合并
+		std::atomic_flag lock;	// 自旋锁: pending、latest和keyed
+		bool pending;		// 队列中已有标记
+		Message latest;		// 最新的尚未响应消息
+		std::unordered_map<long, Message> keyed;	// 按SHARD_PAR1分组时, 各参数1最新的尚未响应消息
+		MQIdStats stats;	// 统计
+
+	public:
+		Handler(long _id) : id(_id) {
+			coalesce = false;
+			lock.clear();
+			pending = false;
+		}
+	};
 	using MQ = boost::interprocess::message_queue;	///< boost消息队列
 	using MQPtr = boost::shared_ptr<MQ>;	///< boost消息队列指针
 	using MtxLck = boost::unique_lock<boost::mutex>;	///< 信号灯互斥锁
 	using ThreadPtr = boost::shared_ptr<boost::thread>;	///< boost线程指针
+	using Lane = MPSCQueue<Message>;	///< 进程内消息通道
+	using LanePtr = boost::shared_ptr<Lane>;	///< 进程内消息通道指针
+	using Registry = MQRegistry<Handler>;	///< 消息注册表
+	using Timers = MQTimerWheel<Message>;	///< 定时器时间轮
+	using TimersPtr = boost::shared_ptr<Timers>;	///< 时间轮指针
+
+	struct Worker {// 工作线程
+		Lane queue;		// 待响应消息
+		std::atomic<bool> waiting;	// 等待新消息
+		boost::mutex mtx;	// 等待互斥锁
+		boost::condition_variable cv;	// 唤醒工作线程
+		ThreadPtr thrd;		// 线程
+		std::atomic<long> maxdepth;	// 最大队列深度
+		std::atomic<long> handled;	// 已响应消息数量
+
+	public:
+		Worker(size_t capacity) : queue(capacity) {
+			waiting  = false;
+			maxdepth = 0;
+			handled  = 0;
+		}
+	};
+	using WorkerPtr = boost::shared_ptr<Worker>;	///< 工作线程指针
+	using WorkerVec = std::vector<WorkerPtr>;	///< 工作线程集合
+	using JournalPtr = boost::shared_ptr<MQJournal>;	///< 记录文件指针
 
 protected:
 	/* 成员变量 */
 	//////////////////////////////////////////////////////////////////////////////
 	enum {
+		SIZE_COALESCED = -1	///< Message::size: 可合并消息的标记, 参数与负载存储在注册表中
+	};
+
+	enum {
+		MSG_STATS = -2,	///< 内部消息: 定时将统计写入日志
+		MSG_TIMER = -1,	///< 内部消息: 唤醒响应线程处理定时器请求
 		MSG_QUIT = 0,	///< 结束消息队列
 		MSG_USER		///< 用户自定义消息起始编号
 	};
 
 	//////////////////////////////////////////////////////////////////////////////
 	/* 消息队列 */
-	const long szFunc_;	///< 自定义回调函数数组长度
+	int backend_;		///< 消息队列后端
 	MQPtr mqptr_;		///< 消息队列
-	CBArray funcs_;		///< 回调函数数组
+	LanePtr lane_high_;	///< 进程内后端: 高优先级通道
+	LanePtr lane_low_;	///< 进程内后端: 低优先级通道
+	std::atomic<bool> waiting_;	///< 进程内后端: 响应线程等待新消息
+	boost::mutex mtx_wait_;		///< 进程内后端: 等待互斥锁
+	boost::condition_variable cv_wait_;	///< 进程内后端: 唤醒响应线程
+	Registry registry_;	///< 消息注册表
+	TimersPtr timers_;	///< 定时器时间轮
+	std::atomic<bool> timer_wake_;	///< 已投递MSG_TIMER, 尚未响应
+	int nworker_;		///< 工作线程数量. 0: 在消息响应线程中直接响应
+	int shardkey_;		///< 分组依据
+	WorkerVec workers_;	///< 工作线程
+	std::atomic<int> ncoalesce_;	///< 可合并消息数量
+	int szbatch_;		///< 批量读出消息数量
+	boost::shared_array<Message> batch_;	///< 批量读出的消息
+	std::atomic<bool> stats_;	///< 启用统计
+	std::atomic<uint64_t> unhandled_;	///< 未注册响应函数的消息数量
+	GLog* statslog_;		///< 定时写入统计的日志
+	TimerHandle statstimer_;	///< 定时写入统计的定时器
+	std::atomic<bool> journaling_;	///< 正在记录
+	JournalPtr journal_;	///< 记录文件
+	MQHandlePool handles_;	///< 大负载句柄槽位池
 	std::string errmsg_;///< 错误原因
 
 	/* 多线程 */
@@ -68,23 +204,136 @@ public:
 	virtual ~MessageQueue();
 	/*!
 	 * @brief 创建消息队列并启动监测/响应服务
-	 * @param name 消息队列名称
+	 * @param name    消息队列名称. 进程内后端不使用
+	 * @param backend 消息队列后端
 	 * @return
 	 * 操作结果. false代表失败
 	 */
-	bool Start(const char *name);
+	bool Start(const char *name, const int backend = MQ_IPC);
+	/*!
+	 * @brief 设置多工作线程分派. 在Start()之前调用
+	 * @param n   工作线程数量. 0: 在消息响应线程中直接响应
+	 * @param key 分组依据. 同组消息由同一工作线程按投递顺序响应
+	 * @return
+	 * 设置结果. 服务已启动时返回false
+	 */
+	bool SetWorkers(const int n, const int key = SHARD_ID);
+	/*!
+	 * @brief 查看工作线程统计
+	 * @param i     工作线程序号
+	 * @param stats 统计
+	 * @return
+	 * 序号无效时返回false
+	 */
+	bool GetWorkerStats(const int i, WorkerStats& stats);
+	/*!
+	 * @brief 设置响应线程每次唤醒后最多读出的消息数量. 在Start()之前调用
+	 * @param n 消息数量
+	 * @return
+	 * 设置结果. 服务已启动时返回false
+	 */
+	bool SetBatchSize(const int n);
+	/*!
+	 * @brief 设置消息是否可合并
+	 * @param id     消息代码. 不小于MSG_USER
+	 * @param enable 可合并
+	 * @return
+	 * 设置结果. 若失败返回false
+	 * @note
+	 * 可合并消息在队列中至多保留一条. 尚未响应时投递的新消息替换其参数与负载, 不占用队列容量.
+	 * 适用于只关心最新状态的消息, 例如温度、曝光进度.
+	 * 按SHARD_PAR1分组时, 合并按(消息代码, 参数1)进行: 不同参数1的消息互不替换, 且由参数1对应的工作线程响应
+	 */
+	bool SetCoalescing(const long id, const bool enable = true);
+	/*!
+	 * @brief 启用或禁用统计
+	 * @note
+	 * 启用后每条消息在投递和响应时各读取两次单调时钟
+	 */
+	void EnableStats(const bool enable = true);
+	/*!
+	 * @brief 查看单个消息编号的统计
+	 * @param id    消息代码
+	 * @param stats 统计
+	 * @return
+	 * 消息未注册时返回false
+	 */
+	bool GetStats(const long id, MessageStats& stats);
+	/*!
+	 * @brief 清除统计
+	 */
+	void ResetStats();
+	/*!
+	 * @brief 生成统计文本, 每个消息编号一行
+	 * @return
+	 * 统计文本
+	 */
+	std::string DumpStats();
+	/*!
+	 * @brief 定时将统计写入日志. 在Start()之后调用
+	 * @param log    日志. NULL: 停止写入
+	 * @param period 周期
+	 */
+	void SetStatsLog(GLog* log, const boost::chrono::milliseconds& period = boost::chrono::seconds(600));
+	/*!
+	 * @brief 开始记录响应的消息
+	 * @param path     记录文件路径. 已存在时覆盖
+	 * @param capacity 记录文件容量, 量纲: 字节. 写满后停止记录
+	 * @return
+	 * 操作结果. 失败原因由GetError()查看
+	 * @note
+	 * - 记录消息编号、参数、负载和投递时刻(未启用统计时为响应时刻). 大负载记录其原始字节
+	 * - WINDOWS平台不支持记录, 返回false
+	 */
+	bool StartJournal(const char *path, const size_t capacity = MQ_JOURNAL_SIZE);
+	/*!
+	 * @brief 停止记录, 记录文件截断至实际长度
+	 * @return
+	 * 因容量不足未记录的消息数量
+	 */
+	uint64_t StopJournal();
+	/*!
+	 * @brief 在调用线程中重放记录文件
+	 * @param path    记录文件路径
+	 * @param timed   true: 按记录的时间间隔重放; false: 全速重放
+	 * @param elapsed 重放耗时, 量纲: 秒
+	 * @return
+	 * 重放的消息数量. 文件无效时返回-1
+	 * @note
+	 * - 消息直接交付已注册的响应函数, 不经过消息队列. 若尚未注册消息, 先调用register_messages()
+	 * - 负载视图指向记录文件映射区, 不含大负载句柄
+	 * - WINDOWS平台不支持重放, 返回-1
+	 */
+	long Replay(const char *path, const bool timed = false, double *elapsed = NULL);
 	/*!
 	 * @brief 停止消息队列监测/响应服务, 并销毁消息队列
 	 */
 	virtual void Stop();
 	/*!
 	 * @brief 注册消息及其响应函数
-	 * @param id   消息代码
+	 * @param id   消息代码. 不小于MSG_USER
 	 * @param slot 回调函数插槽
 	 * @return
 	 * 消息注册结果. 若失败返回false
+	 * @note
+	 * 可在消息队列运行期间调用. 同一消息重复注册时替换已有响应函数
 	 */
 	bool RegisterMessage(const long id, const CBSlot& slot);
+	/*!
+	 * @brief 注册负载消息及其响应函数
+	 * @param id   消息代码
+	 * @param slot 回调函数插槽. 负载视图仅在回调函数内有效
+	 * @return
+	 * 消息注册结果. 若失败返回false
+	 * @note
+	 * 同一消息可同时注册RegisterMessage()的响应函数, 二者均被调用
+	 */
+	bool RegisterPayload(const long id, const PLSlot& slot);
+	/*!
+	 * @brief 注销消息的全部响应函数
+	 * @param id 消息代码
+	 */
+	void UnregisterMessage(const long id);
 	/*!
 	 * @brief 投递低优先级消息
 	 * @param id   消息代码
@@ -99,6 +348,81 @@ public:
 	 * @param par2 参数2
 	 */
 	void SendMessage(const long id, const long par1 = 0, const long par2 = 0);
+	/*!
+	 * @brief 投递携带小负载的低优先级消息. 负载被拷贝至消息内部
+	 * @param id   消息代码
+	 * @param data 负载
+	 * @param n    负载长度. 不大于MQ_PAYLOAD_INLINE
+	 * @param par1 参数1
+	 * @param par2 参数2
+	 * @return
+	 * 投递结果. 负载过长时返回false
+	 */
+	bool PostPayload(const long id, const void *data, const int n, const long par1 = 0, const long par2 = 0);
+	/*!
+	 * @brief 投递携带大负载的低优先级消息. 仅传递句柄, 不拷贝负载
+	 * @param id     消息代码
+	 * @param handle 负载句柄
+	 * @param n      负载长度
+	 * @param par1   参数1
+	 * @param par2   参数2
+	 * @return
+	 * 投递结果. 句柄为空或无空闲句柄槽位时返回false
+	 * @note
+	 * - 句柄仅在进程内有效
+	 * - 句柄槽位由尚未处理完毕的大负载消息占用. 槽位耗尽时不等待, 调用者可稍后重试
+	 */
+	bool PostPayload(const long id, const MQPayloadPtr& handle, const int n, const long par1 = 0, const long par2 = 0);
+	/*!
+	 * @brief 投递携带小负载的高优先级消息
+	 */
+	bool SendPayload(const long id, const void *data, const int n, const long par1 = 0, const long par2 = 0);
+	/*!
+	 * @brief 投递携带大负载的高优先级消息
+	 */
+	bool SendPayload(const long id, const MQPayloadPtr& handle, const int n, const long par1 = 0, const long par2 = 0);
+	/*!
+	 * @brief 延时投递消息
+	 * @param delay 延时
+	 * @param id    消息代码
+	 * @param par1  参数1
+	 * @param par2  参数2
+	 * @return
+	 * 定时器句柄. 失败时返回0
+	 * @note
+	 * 到期消息在响应线程中直接调用响应函数, 不经过消息队列
+	 */
+	TimerHandle PostMessageAfter(const boost::chrono::milliseconds& delay, const long id,
+			const long par1 = 0, const long par2 = 0);
+	/*!
+	 * @brief 在指定时刻投递消息
+	 * @param utc  UTC时刻. 已过去时立即投递
+	 * @param id   消息代码
+	 * @param par1 参数1
+	 * @param par2 参数2
+	 * @return
+	 * 定时器句柄. 失败时返回0
+	 */
+	TimerHandle PostMessageAt(const boost::posix_time::ptime& utc, const long id,
+			const long par1 = 0, const long par2 = 0);
+	/*!
+	 * @brief 周期投递消息
+	 * @param period 周期
+	 * @param id     消息代码
+	 * @param par1   参数1
+	 * @param par2   参数2
+	 * @return
+	 * 定时器句柄. 失败时返回0
+	 * @note
+	 * 首次投递在一个周期之后. 由CancelTimer()结束
+	 */
+	TimerHandle PostMessageEvery(const boost::chrono::milliseconds& period, const long id,
+			const long par1 = 0, const long par2 = 0);
+	/*!
+	 * @brief 取消尚未到期的定时器
+	 * @param timer 定时器句柄
+	 */
+	void CancelTimer(const TimerHandle timer);
 	/*!
 	 * @brief 查看错误提示
 	 * @return
@@ -114,11 +438,95 @@ protected:
 	virtual void register_messages() = 0;
 
 protected:
+	/*!
+	 * @brief 检查消息队列是否已创建
+	 */
+	bool is_created();
+	/*!
+	 * @brief 向消息队列写入消息. 进程内后端队列满时等待
+	 * @param msg    消息
+	 * @param urgent 高优先级
+	 */
+	void send_message(const Message& msg, const bool urgent);
+	/*!
+	 * @brief 投递携带小负载的消息
+	 */
+	bool send_payload(const long id, const void *data, const int n, const long par1, const long par2, const bool urgent);
+	/*!
+	 * @brief 投递携带大负载的消息. 无空闲句柄槽位时返回false
+	 */
+	bool send_payload(const long id, const MQPayloadPtr& handle, const int n, const long par1, const long par2, const bool urgent);
+	/*!
+	 * @brief 合并消息
+	 * @param handler 注册表项
+	 * @param msg     新消息
+	 * @return
+	 * 需要向队列写入标记时返回true
+	 */
+	bool coalesce(Handler& handler, const Message& msg);
+	/*!
+	 * @brief 批量读出消息. 无消息时阻塞
+	 * @param tick 最长等待至时间轮刻度. Timers::never: 无限等待
+	 * @return
+	 * 读出消息数量. 0: 超时
+	 */
+	int receive_batch(const uint64_t tick);
+	/*!
+	 * @brief 从消息队列读出消息. 无消息时阻塞
+	 * @param msg  消息
+	 * @param tick 最长等待至时间轮刻度. Timers::never: 无限等待
+	 * @return
+	 * 读出消息时返回true, 超时返回false
+	 */
+	bool receive_message(Message& msg, const uint64_t tick);
+	/*!
+	 * @brief 添加定时器并唤醒响应线程
+	 */
+	TimerHandle add_timer(const Message& msg, const int64_t delay, const int64_t period);
 	/*!
 	 * @brief 中止线程
 	 * @param thrd 线程指针
 	 */
 	void interrupt_thread(ThreadPtr& thrd);
+	/*!
+	 * @brief 调用消息的响应函数, 并释放大负载句柄
+	 * @param msg 消息
+	 */
+	void dispatch(const Message& msg);
+	/*!
+	 * @brief 调用响应函数并统计
+	 * @param handler 注册表项
+	 * @param msg     消息
+	 * @param payload 负载视图
+	 */
+	void invoke(Handler& handler, const Message& msg, const MQPayload& payload);
+	/*!
+	 * @brief 在消息响应线程中直接响应消息, 或按分组交由工作线程
+	 * @param msg 消息
+	 */
+	void route(const Message& msg);
+	/*!
+	 * @brief 响应到期定时器
+	 * @param msg 消息
+	 */
+	void fire_timer(const Message& msg);
+	/*!
+	 * @brief 将统计写入日志
+	 */
+	void log_stats();
+	/*!
+	 * @brief 启动工作线程
+	 */
+	void start_workers();
+	/*!
+	 * @brief 工作线程处理完已分派消息后退出
+	 */
+	void stop_workers();
+	/*!
+	 * @brief 线程, 响应分派至工作线程的消息
+	 * @param worker 工作线程
+	 */
+	void thread_worker(Worker* worker);
 	/*!
 	 * @brief 线程, 监测/响应消息
 	 */
@@ -6,6 +6,7 @@
 
 #include <boost/bind.hpp>
 #include <boost/asio/placeholders.hpp>
+#include <boost/array.hpp>
 #include "SerialComm.h"
 
 #define SERIAL_BUFF_SIZE		512
@@ -13,8 +14,10 @@
 using namespace boost::asio;
 using namespace boost::placeholders;
 
-SerialComm::SerialComm()
-	: port_(keep_.GetIOService()) {
+SerialComm::SerialComm(IOKeepPtr keep)
+	: keep_(keep.use_count() ? keep : AsioIOServiceKeep::Create()),
+	  strand_(keep_->GetIOService()),
+	  port_(keep_->GetIOService()) {
 	bufrcv_.reset(new char[SERIAL_BUFF_SIZE]);
 	crcrcv_.set_capacity(SERIAL_BUFF_SIZE * 5);
 	crcsnd_.set_capacity(SERIAL_BUFF_SIZE * 5);
@@ -24,8 +27,8 @@ SerialComm::~SerialComm() {
 	Close();
 }
 
-SerialComm::Pointer SerialComm::Create() {
-	return Pointer(new SerialComm);
+SerialComm::Pointer SerialComm::Create(IOKeepPtr keep) {
+	return Pointer(new SerialComm(keep));
 }
 
 bool SerialComm::Open(const string& portname, const int baud_rate) {
@@ -58,21 +61,18 @@ int SerialComm::Lookup(const char* flag, const int len, const int from) {
 	if (!flag || len <= 0 || from < 0) return -1;
 
 	mutex_lock lck(mtxrcv_);
-	int n(crcrcv_.size() - len), pos, i, j;
-	for (pos = from, i = -1; i != len && pos <= n; ++pos) {
-		for (i = 0, j = pos; i < len && flag[i] == crcrcv_[j]; ++i, ++j);
-	}
-	return (i == len) ? (pos - 1) : -1;
+	size_t pos = crcrcv_.find(flag, len, from);
+	return (pos == crcbuff::npos) ? -1 : int(pos);
 }
 
 int SerialComm::Write(const char* buff, const int len) {
 	if (!buff || len <= 0 || !port_.is_open()) return 0;
 
 	mutex_lock lck(mtxsnd_);
-	int n0(crcsnd_.size()), n(crcsnd_.capacity() - n0), i;
+	int n0(crcsnd_.size()), n(crcsnd_.reserve());
 
 	if (n > len) n = len;
-	for (i = 0; i < n; ++i) crcsnd_.push_back(buff[i]);
+	crcsnd_.push_back(buff, n);
 	if (!n0 && port_.is_open()) start_write();
 	return n;
 }
@@ -82,13 +82,9 @@ int SerialComm::Read(char* buff, const int len, const int from) {
 
 	mutex_lock lck(mtxrcv_);
 	int end(from + len);
-	int to_read = crcrcv_.size() > end ? len : crcrcv_.size() - from;
+	int to_read = crcrcv_.copy(buff, len, from);
 
-	if (to_read) {
-		int i, j;
-		for (i = 0, j = from; i < to_read; ++i, ++j) buff[i] = crcrcv_[j];
-		crcrcv_.erase_begin(end);
-	}
+	if (to_read) crcrcv_.erase_begin(end);
 	return to_read;
 }
 
@@ -107,7 +103,7 @@ void SerialComm::RegisterWrite(const CBSlot& slot) {
 void SerialComm::handle_read(const error_code& ec, int n) {
 	if (!ec) {
 		mutex_lock lock(mtxrcv_);
-		for(int i = 0; i < n; ++i) crcrcv_.push_back(bufrcv_[i]);
+		crcrcv_.push_back(bufrcv_.get(), n);
 	}
 	cbrcv_(shared_from_this(), ec);
 	if (!ec) start_read();
@@ -124,15 +120,19 @@ void SerialComm::handle_write(const error_code& ec, int n) {
 
 void SerialComm::start_read() {
 	port_.async_read_some(buffer(bufrcv_.get(), SERIAL_BUFF_SIZE),
-			boost::bind(&SerialComm::handle_read, shared_from_this(),
-					placeholders::error, placeholders::bytes_transferred));
+			strand_.wrap(boost::bind(&SerialComm::handle_read, shared_from_this(),
+					placeholders::error, placeholders::bytes_transferred)));
 }
 
 void SerialComm::start_write() {
-	int n(crcsnd_.size());
-	if (n) {
-		port_.async_write_some(boost::asio::buffer(crcsnd_.linearize(), n),
-				boost::bind(&SerialComm::handle_write, shared_from_this(),
-						placeholders::error, placeholders::bytes_transferred));
+	if (crcsnd_.size()) {
+		crcbuff::array_range one = crcsnd_.array_one();
+		crcbuff::array_range two = crcsnd_.array_two();
+		boost::array<const_buffer, 2> bufs = {{
+			buffer(one.first, one.second), buffer(two.first, two.second)
+		}};
+		port_.async_write_some(bufs,
+				strand_.wrap(boost::bind(&SerialComm::handle_write, shared_from_this(),
+						placeholders::error, placeholders::bytes_transferred)));
 	}
 }
@@ -9,26 +9,38 @@
  * - 读出数据
  * - 写入数据
  * - 异常处理
+ * @version 0.2
+ * @date 2026-10-16
+ * - 可挂接共享AsioIOServiceKeep
+ * - 使用strand串行化回调函数
+ * - 收发缓冲区改用ByteRing, 整段拷贝, 发送时不再linearize()
+ * - Lookup()使用memchr/Boyer-Moore-Horspool查找, 重复查找时仅检查新增数据
+ * - 回调函数改用单目标Callback, 触发时不加锁
  */
 
 #ifndef SERIALCOMM_H_
 #define SERIALCOMM_H_
 
 #include <string>
-#include <boost/signals2.hpp>
-#include <boost/circular_buffer.hpp>
+#include <boost/thread/mutex.hpp>
 #include <boost/asio/serial_port.hpp>
 #include <boost/smart_ptr/shared_array.hpp>
 #include <boost/enable_shared_from_this.hpp>
 #include <boost/system/error_code.hpp>
 #include "AsioIOServiceKeep.h"
+#include "ByteRing.h"
+#include "Callback.h"
 
 using std::string;
 using boost::system::error_code;
 
 class SerialComm : public boost::enable_shared_from_this<SerialComm> {
 public:
-	SerialComm();
+	/*!
+	 * @brief 构造函数
+	 * @param keep io_service线程池. 为空时创建独占实例
+	 */
+	SerialComm(IOKeepPtr keep = IOKeepPtr());
 	virtual ~SerialComm();
 
 public:
@@ -39,19 +51,20 @@ public:
 	 * @param _1 对象指针
 	 * @param _2 错误代码. 0: 正确
 	 */
-	typedef boost::signals2::signal<void (Pointer, const boost::system::error_code&)> CallbackFunc;
-	// 基于boost::signals2声明插槽类型
+	typedef Callback<void (Pointer, const boost::system::error_code&)> CallbackFunc;
+	// 声明插槽类型
 	typedef CallbackFunc::slot_type CBSlot;
 
 protected:
 	/* 数据类型 */
 	typedef boost::unique_lock<boost::mutex> mutex_lock;	//< 互斥锁
-	typedef boost::circular_buffer<char> crcbuff;	//< 循环缓冲区
+	typedef ByteRing crcbuff;	//< 循环缓冲区
 	typedef boost::shared_array<char> carray;		//< 字符型数组
 
 protected:
 	/* 成员变量 */
-	AsioIOServiceKeep keep_;		//< 提供io_service对象
+	IOKeepPtr keep_;		//< 提供io_service对象
+	AsioIOServiceKeep::Strand strand_;	//< 串行化本实例的回调函数
 	boost::asio::serial_port port_;	//< 串口
 	CallbackFunc  cbrcv_;	//< receive回调函数
 	CallbackFunc  cbsnd_;	//< send回调函数
@@ -64,7 +77,11 @@ protected:
 
 public:
 	/* 接口 */
-	static Pointer Create();
+	/*!
+	 * @brief 创建对象实例
+	 * @param keep io_service线程池. 为空时创建独占实例
+	 */
+	static Pointer Create(IOKeepPtr keep = IOKeepPtr());
 	/*!
 	 * @brief 尝试打开串口
 	 * @param portname  串口名称
@@ -0,0 +1,215 @@
+/**
+ * @file TcpFramer.h 基于TcpClient接收缓冲区的分帧器
+ * @version 0.1
+ * @date 2026-10-16
+ * @note
+ * - TcpFramerLine:   以分隔符(缺省为换行符)结尾的文本帧
+ * - TcpFramerLength: 以1/2/4字节长度前缀起始的二进制帧
+ * - TcpFramerFixed:  定长记录
+ * @note
+ * 使用方法:
+ * 1. TcpClient::SetFramer()设置分帧器
+ * 2. TcpClient::RegisterFrame()注册回调函数
+ * 3. 每次接收网络信息后, 所有完整帧在一次回调中以Frame数组形式交付.
+ *    Frame直接指向接收缓冲区, 不拷贝数据, 仅在回调函数内有效
+ * 4. 接收数据按缓冲区剩余空间分段写入, 每段写入后提取完整帧, 不覆盖尚未分帧的数据.
+ *    帧长度上限为缓冲区容量, 更长的帧视为无效
+ */
+
+#ifndef SRC_TCPFRAMER_H_
+#define SRC_TCPFRAMER_H_
+
+#include <string>
+#include <vector>
+#include <boost/smart_ptr/shared_ptr.hpp>
+#include "ByteRing.h"
+
+/*!
+ * @struct Frame 一帧数据在接收缓冲区中的视图
+ */
+struct Frame {
+	ByteRing::array_range one;	///< 第一段
+	ByteRing::array_range two;	///< 第二段. 帧未跨越缓冲区尾部时长度为0
+
+public:
+	/*!
+	 * @brief 帧长度, 量纲: 字节
+	 */
+	size_t size() const {
+		return one.second + two.second;
+	}
+
+	/*!
+	 * @brief 帧是否为连续存储区. 连续时可直接使用one.first
+	 */
+	bool contiguous() const {
+		return two.second == 0;
+	}
+
+	/*!
+	 * @brief 拷贝帧数据
+	 * @param data 输出存储区, 长度不小于size()
+	 * @return
+	 * 拷贝长度
+	 */
+	size_t copy(char* data) const {
+		memcpy(data, one.first, one.second);
+		if (two.second) memcpy(data + one.second, two.first, two.second);
+		return size();
+	}
+};
+
+class TcpFramer {
+public:
+	using Pointer = boost::shared_ptr<TcpFramer>;
+
+public:
+	virtual ~TcpFramer() {}
+	/*!
+	 * @brief 从接收缓冲区的from位置开始检查一帧
+	 * @param ring   接收缓冲区
+	 * @param from   起始位置
+	 * @param offset 有效数据相对from的偏移量
+	 * @param len    有效数据长度
+	 * @return
+	 * >0: 帧总长度, 含分隔符/长度前缀
+	 * =0: 数据不完整
+	 * <0: 数据无效, 无法继续分帧
+	 */
+	virtual int Next(ByteRing& ring, size_t from, size_t& offset, size_t& len) = 0;
+
+	/*!
+	 * @brief 将接收数据写入缓冲区并提取完整帧
+	 * @param ring    接收缓冲区
+	 * @param data    接收数据
+	 * @param n       数据长度
+	 * @param frames  帧数组, 交付时使用
+	 * @param deliver 交付回调函数, 形式为deliver(std::vector<Frame>&). 交付后帧从缓冲区清除
+	 * @return
+	 * 数据可以分帧. 否则清空缓冲区
+	 * @note
+	 * 数据按缓冲区剩余空间分段写入. 缓冲区已满仍无法提取帧时, 帧长度超出缓冲区容量
+	 */
+	template<typename Deliver>
+	bool Feed(ByteRing& ring, const char* data, size_t n, std::vector<Frame>& frames, Deliver deliver) {
+		size_t from, offset, len, chunk;
+		int rslt(0);
+		Frame frame;
+
+		while (n && rslt >= 0) {
+			if (!(chunk = n < ring.reserve() ? n : ring.reserve())) {
+				rslt = -1;
+				break;
+			}
+			ring.push_back(data, chunk);
+			data += chunk;
+			n    -= chunk;
+
+			frames.clear();
+			for (from = 0; (rslt = Next(ring, from, offset, len)) > 0; from += rslt) {
+				ring.range(from + offset, len, frame.one, frame.two);
+				frames.push_back(frame);
+			}
+			if (frames.size()) deliver(frames);
+			ring.erase_begin(from);
+		}
+		if (rslt < 0) ring.clear();
+		return rslt >= 0;
+	}
+};
+using TcpFramerPtr = TcpFramer::Pointer;
+
+/*!
+ * @class TcpFramerLine 以分隔符结尾的帧
+ */
+class TcpFramerLine : public TcpFramer {
+protected:
+	std::string delim_;	///< 分隔符
+	bool keep_;			///< 有效数据是否包含分隔符
+
+public:
+	/*!
+	 * @param delim 分隔符
+	 * @param keep  有效数据是否包含分隔符
+	 */
+	TcpFramerLine(const std::string& delim = "\n", bool keep = false)
+		: delim_(delim), keep_(keep) {
+	}
+
+	static TcpFramerPtr Create(const std::string& delim = "\n", bool keep = false) {
+		return TcpFramerPtr(new TcpFramerLine(delim, keep));
+	}
+
+	int Next(ByteRing& ring, size_t from, size_t& offset, size_t& len) {
+		size_t pos = ring.find(delim_.data(), delim_.size(), from);
+		if (pos == ByteRing::npos) {// 缓冲区已满仍无分隔符: 行长度超出缓冲区容量
+			return ring.size() - from == ring.capacity() ? -1 : 0;
+		}
+		offset = 0;
+		len = pos - from + (keep_ ? delim_.size() : 0);
+		return int(pos - from + delim_.size());
+	}
+};
+
+/*!
+ * @class TcpFramerLength 以长度前缀起始的帧
+ * @note
+ * 长度前缀为无符号整数, 网络字节序, 不含前缀自身长度
+ */
+class TcpFramerLength : public TcpFramer {
+protected:
+	int width_;			///< 长度前缀字节数: 1, 2或4
+	size_t maxlen_;		///< 有效数据最大长度
+
+public:
+	/*!
+	 * @param width  长度前缀字节数: 1, 2或4
+	 * @param maxlen 有效数据最大长度. 超出时视为无效数据
+	 */
+	TcpFramerLength(int width = 4, size_t maxlen = 65536) {
+		width_  = (width == 1 || width == 2) ? width : 4;
+		maxlen_ = maxlen;
+	}
+
+	static TcpFramerPtr Create(int width = 4, size_t maxlen = 65536) {
+		return TcpFramerPtr(new TcpFramerLength(width, maxlen));
+	}
+
+	int Next(ByteRing& ring, size_t from, size_t& offset, size_t& len) {
+		if (ring.size() < from + width_) return 0;
+		len = 0;
+		for (int i = 0; i < width_; ++i)
+			len = (len << 8) | (unsigned char) ring[from + i];
+		if (len > maxlen_ || width_ + len > ring.capacity()) return -1;
+		if (ring.size() < from + width_ + len) return 0;
+		offset = width_;
+		return int(width_ + len);
+	}
+};
+
+/*!
+ * @class TcpFramerFixed 定长记录
+ */
+class TcpFramerFixed : public TcpFramer {
+protected:
+	size_t size_;	///< 记录长度
+
+public:
+	TcpFramerFixed(size_t size) {
+		size_ = size ? size : 1;
+	}
+
+	static TcpFramerPtr Create(size_t size) {
+		return TcpFramerPtr(new TcpFramerFixed(size));
+	}
+
+	int Next(ByteRing& ring, size_t from, size_t& offset, size_t& len) {
+		if (size_ > ring.capacity()) return -1;
+		if (ring.size() < from + size_) return 0;
+		offset = 0;
+		len = size_;
+		return int(size_);
+	}
+};
+
+#endif /* SRC_TCPFRAMER_H_ */
@@ -0,0 +1,100 @@
+/**
+ * @file BenchAsioUDP.cpp UDP批量收发的性能测试
+ * @version 0.1
+ * @date 2026-10-16
+ * @note
+ * - 本机回环, 发送方以WriteBatch()每批发送batch个数据包, 接收方由recvmmsg批量读入接收队列,
+ *   消费线程以Read()取出
+ * - 统计发送速率、接收数量、接收队列丢弃数量与乱序数量. kernel: 套接口接收缓冲区溢出,
+ *   即未被读入接收队列的数据包数量
+ * - 用法: bench_udp [数据包数量] [数据包长度]. 缺省为1000000个, 200字节
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "../AsioUDP.h"
+#include "BenchUtil.h"
+
+/*!
+ * @brief 运行一组测试
+ * @param total  数据包数量
+ * @param size   数据包长度
+ * @param batch  每批发送的数据包数量
+ * @param port   接收端口
+ */
+static void run(long total, int size, int batch, uint16_t port) {
+	IOKeepPtr keep = AsioIOServiceKeep::Create(1);
+	UdpCPtr rx = AsioUDP::Create(keep);
+	UdpCPtr tx = AsioUDP::Create(keep);
+	rx->SetQueueSize(4096);
+	if (!rx->Open(port) || !tx->Open()) {
+		printf("failed to open port %u\n", port);
+		return;
+	}
+	boost::system::error_code ec;
+	rx->GetSocket().set_option(boost::asio::socket_base::receive_buffer_size(4 * 1024 * 1024), ec);
+
+	std::atomic<bool> done(false);
+	long got(0), disorder(0);
+	std::thread consumer([&]() {
+		char buf[UDP_PACK_SIZE];
+		int n;
+		long expect(0), seq;
+		while (!done.load() || rx->Available()) {
+			if (!rx->BlockRead(buf, n, 10)) continue;
+			memcpy(&seq, buf, sizeof(seq));
+			if (seq < expect) ++disorder;
+			expect = seq + 1;
+			++got;
+		}
+	});
+
+	AsioUDP::UDP::endpoint peer;
+	AsioUDP::Endpoint("127.0.0.1", port, peer);
+	std::vector<char> payload(size_t(batch) * size);
+	std::vector<AsioUDP::Datagram> dgrams(batch);
+	long sent(0);
+	int64_t t0 = bench_now();
+	while (sent < total) {
+		int n = int(std::min(long(batch), total - sent));
+		for (int i = 0; i < n; ++i) {
+			long seq = sent + i;
+			char* ptr = payload.data() + size_t(i) * size;
+			memcpy(ptr, &seq, sizeof(seq));
+			dgrams[i].data = ptr;
+			dgrams[i].n    = size;
+			dgrams[i].peer = &peer;
+		}
+		int k = tx->WriteBatch(dgrams.data(), n);
+		if (k > 0) sent += k;
+		else std::this_thread::yield();	// 内核发送缓冲区已满
+	}
+	double dt = (bench_now() - t0) * 1E-9;
+	bench_sleep(200);
+	done = true;
+	consumer.join();
+
+	long dropped = long(rx->GetDropped());
+	printf("%6d %10ld %12.0f %10ld %10ld %10ld %10ld\n", batch, sent, sent / dt, got,
+			dropped, sent - got - dropped, disorder);
+	rx->Close();
+	tx->Close();
+}
+
+int main(int argc, char** argv) {
+	long total = argc > 1 ? atol(argv[1]) : 1000000;
+	int size = argc > 2 ? atoi(argv[2]) : 200;
+	int batches[] = { 1, 8, 32 };
+	uint16_t port(43000);
+
+	if (size < int(sizeof(long))) size = sizeof(long);
+	if (size > UDP_PACK_SIZE) size = UDP_PACK_SIZE;
+	printf("%6s %10s %12s %10s %10s %10s %10s\n", "batch", "sent", "pkt/s", "received", "dropped", "kernel", "disorder");
+	for (size_t i = 0; i < sizeof(batches) / sizeof(batches[0]); ++i)
+		run(total, size, batches[i], port++);
+	return 0;
+}
@@ -0,0 +1,135 @@
+/**
+ * @file BenchByteRing.cpp 收发缓冲区的吞吐量测试
+ * @version 0.1
+ * @date 2026-10-16
+ * @note
+ * - buffer: 内存中模拟TcpClient的收发路径, 对比改造前后的缓冲区操作
+ *   old: boost::circular_buffer<char>, 逐字节push_back写入、逐字节读出, 发送前linearize()
+ *   new: ByteRing, 整段memcpy写入与读出, 发送时直接使用array_one()/array_two()
+ * - loopback: 本机回环TCP, TcpClient以给定消息长度发送, 对端读出, 统计实际吞吐量
+ * - 用法: bench_ring [总量MB]. 缺省为64MB
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <vector>
+#include <boost/bind/bind.hpp>
+#include <boost/circular_buffer.hpp>
+#include "../AsioTCP.h"
+#include "BenchUtil.h"
+
+using namespace boost::placeholders;
+
+static volatile char sink;	///< 防止读出操作被优化
+
+/*!
+ * @brief 改造前: 逐字节写入, 逐字节读出; 发送路径整理为连续存储区
+ */
+static double run_old(const std::vector<char>& msg, size_t total) {
+	size_t n = msg.size();
+	boost::circular_buffer<char> rx(n * 2), tx(n * 2);
+	std::vector<char> out(n);
+	int64_t t0 = bench_now();
+	for (size_t done = 0; done < total; done += n) {
+		for (size_t i = 0; i < n; ++i) rx.push_back(msg[i]);	// handle_read
+		for (size_t i = 0; i < n; ++i) out[i] = rx[i];			// Read
+		rx.erase_begin(n);
+		for (size_t i = 0; i < n; ++i) tx.push_back(out[i]);	// Write
+		sink = *tx.linearize();									// start_write
+		tx.erase_begin(n);
+	}
+	return total / ((bench_now() - t0) * 1E-9) / 1048576.0;
+}
+
+/*!
+ * @brief 改造后: 整段拷贝, 发送路径使用两段连续区
+ */
+static double run_new(const std::vector<char>& msg, size_t total) {
+	size_t n = msg.size();
+	ByteRing rx(n * 2), tx(n * 2);
+	std::vector<char> out(n);
+	int64_t t0 = bench_now();
+	for (size_t done = 0; done < total; done += n) {
+		rx.push_back(msg.data(), n);		// handle_read
+		rx.copy(out.data(), n);				// Read
+		rx.erase_begin(n);
+		tx.push_back(out.data(), n);		// Write
+		sink = *tx.array_one().first;		// start_write
+		tx.erase_begin(n);
+	}
+	return total / ((bench_now() - t0) * 1E-9) / 1048576.0;
+}
+
+class BenchLoopback {
+protected:
+	TcpCPtr peer_;		///< 服务器端连接
+	std::atomic<bool> accepted_;
+	std::atomic<size_t> received_;
+	char buf_[65536];
+
+public:
+	/*!
+	 * @brief 本机回环吞吐量, 量纲: MB/s
+	 */
+	double Run(const std::vector<char>& msg, size_t total, uint16_t port) {
+		IOKeepPtr keep = AsioIOServiceKeep::Create(2);
+		TcpSPtr server = TcpServer::Create(keep);
+		server->RegisterAccept(boost::bind(&BenchLoopback::on_accept, this, _1, _2));
+		if (!server->CreateServer(port)) {
+			printf("failed to listen on port %u\n", port);
+			return 0.0;
+		}
+
+		TcpCPtr client = TcpClient::Create(keep);
+		received_ = 0;
+		accepted_ = false;
+		peer_.reset();
+		client->SetWaterMark(int(msg.size()) * 64 + TCP_HIGH_WATER, TCP_LOW_WATER);
+		client->Connect("127.0.0.1", port);
+		for (int i = 0; i < 5000 && !accepted_; ++i) bench_sleep(1);
+		if (!accepted_) return 0.0;
+
+		int64_t t0 = bench_now();
+		for (size_t sent = 0; sent < total; ) {
+			if (client->Write(msg.data(), int(msg.size())) > 0) sent += msg.size();
+			else bench_sleep(0);	// 超出高水位: 等待发送
+		}
+		for (int i = 0; i < 30000 && received_.load() < total; ++i) bench_sleep(1);
+		double mbps = received_.load() / ((bench_now() - t0) * 1E-9) / 1048576.0;
+		client->Close();
+		peer_->Close();
+		return mbps;
+	}
+
+protected:
+	void on_accept(const TcpCPtr client, const TcpSPtr) {
+		client->RegisterRead(boost::bind(&BenchLoopback::on_read, this, _1, _2));
+		peer_ = client;
+		accepted_ = true;
+	}
+
+	void on_read(const TcpCPtr client, const error_code& ec) {
+		int n;
+		if (ec) return;
+		while ((n = client->Read(buf_, sizeof(buf_))) > 0) received_ += n;
+	}
+};
+
+int main(int argc, char** argv) {
+	size_t total = size_t(argc > 1 ? atoi(argv[1]) : 64) * 1048576;
+	size_t sizes[] = { 1024, 4096, 16384, 65536, 262144, 1048576 };
+	BenchLoopback loopback;
+	uint16_t port(42000);
+
+	printf("%8s %12s %12s %8s %14s\n", "msg", "old(MB/s)", "new(MB/s)", "speedup", "loopback(MB/s)");
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+		std::vector<char> msg(sizes[i]);
+		for (size_t j = 0; j < msg.size(); ++j) msg[j] = char(j);
+		double vold = run_old(msg, total);
+		double vnew = run_new(msg, total);
+		double vnet = loopback.Run(msg, total, port++);
+		printf("%7zuK %12.0f %12.0f %7.1fx %14.0f\n", sizes[i] / 1024, vold, vnew, vnew / vold, vnet);
+	}
+	return 0;
+}
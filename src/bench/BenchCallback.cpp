@@ -0,0 +1,76 @@
+/**
+ * @file BenchCallback.cpp 回调函数触发开销的性能测试
+ * @version 0.1
+ * @date 2026-10-16
+ * @note
+ * - signals2: 改造前的boost::signals2::signal, 单个插槽
+ * - Callback: 改造后的单目标回调, 参数形式与TcpClient/AsioUDP的回调函数一致
+ * - 单线程及多线程同时触发, 统计每秒触发次数
+ * - 用法: bench_callback [每线程触发次数]. 缺省为10000000
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <boost/bind/bind.hpp>
+#include <boost/signals2/signal.hpp>
+#include <boost/smart_ptr/shared_ptr.hpp>
+#include <boost/system/error_code.hpp>
+#include "../Callback.h"
+#include "BenchUtil.h"
+
+using namespace boost::placeholders;
+
+struct Target {
+	std::atomic<long> count;
+
+public:
+	Target() {
+		count = 0;
+	}
+
+	void on_event(const boost::shared_ptr<int>, const boost::system::error_code& ec) {
+		if (!ec) count.fetch_add(1, std::memory_order_relaxed);
+	}
+};
+
+/*!
+ * @brief 多线程同时触发
+ * @return
+ * 每秒触发次数
+ */
+template<typename Emitter>
+static double run(Emitter& emit, int nthread, long count) {
+	boost::shared_ptr<int> ptr(new int(0));
+	boost::system::error_code ec;
+	std::vector<std::thread> threads;
+	int64_t t0 = bench_now();
+	for (int k = 0; k < nthread; ++k) {
+		threads.emplace_back([&]() {
+			for (long i = 0; i < count; ++i) emit(ptr, ec);
+		});
+	}
+	for (size_t k = 0; k < threads.size(); ++k) threads[k].join();
+	return nthread * count / ((bench_now() - t0) * 1E-9);
+}
+
+int main(int argc, char** argv) {
+	long count = argc > 1 ? atol(argv[1]) : 10000000;
+	int nthreads[] = { 1, 4 };
+	Target target;
+
+	boost::signals2::signal<void (const boost::shared_ptr<int>, const boost::system::error_code&)> sig;
+	sig.connect(boost::bind(&Target::on_event, &target, _1, _2));
+	Callback<void (const boost::shared_ptr<int>, const boost::system::error_code&)> cb;
+	cb.connect(boost::bind(&Target::on_event, &target, _1, _2));
+
+	printf("%8s %16s %16s %8s\n", "threads", "signals2(/s)", "Callback(/s)", "speedup");
+	for (size_t i = 0; i < sizeof(nthreads) / sizeof(nthreads[0]); ++i) {
+		double vsig = run(sig, nthreads[i], count / nthreads[i]);
+		double vcb  = run(cb, nthreads[i], count / nthreads[i]);
+		printf("%8d %16.0f %16.0f %7.1fx\n", nthreads[i], vsig, vcb, vcb / vsig);
+	}
+	return target.count.load() > 0 ? 0 : 1;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file BenchGLog.cpp 日志调用开销的性能测试
+ * @version 0.1
+ * @date 2026-10-16
+ * @note
+ * - 多个线程同时写入同一GLog对象, 统计调用线程每次Write()的耗时p50/p99与平均值
+ * - sync:   同步模式, 调用线程加锁写入并刷新文件
+ * - async:  异步模式, 调用线程格式化至无锁环形队列, 由后台线程写入
+ * - binary: 异步模式下的二进制日志(GLOG_BIN)
+ * - 日志写入临时目录, 测试结束后删除
+ * - 用法: bench_glog [线程数] [每线程日志数]. 缺省为8个线程, 每线程100000条
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../GLog.h"
+#include "BenchUtil.h"
+
+GLog _gLog(stdout);
+
+enum {
+	MODE_SYNC,
+	MODE_ASYNC,
+	MODE_BINARY
+};
+
+static void run(const std::string& dir, int mode, int nthread, int count) {
+	static const char* names[] = { "sync", "async", "binary" };
+	std::vector<std::vector<int64_t> > cost(nthread);
+	std::vector<std::thread> threads;
+	int64_t elapsed;
+	{
+		GLog log(dir.c_str(), names[mode]);
+		if (mode != MODE_SYNC) log.StartAsync();
+		if (mode == MODE_BINARY) log.SetBinary(true);
+
+		int64_t t0 = bench_now();
+		for (int k = 0; k < nthread; ++k) {
+			threads.emplace_back([&log, &cost, k, count, mode]() {
+				std::vector<int64_t>& samples = cost[k];
+				samples.reserve(count);
+				for (int i = 0; i < count; ++i) {
+					int64_t t1 = bench_now();
+					if (mode == MODE_BINARY) GLOG_BIN(log, "bench", LOG_NORMAL, "thread %d line %d value %.3f", k, i, i * 0.5);
+					else log.Write("bench", LOG_NORMAL, "thread %d line %d value %.3f", k, i, i * 0.5);
+					samples.push_back(bench_now() - t1);
+				}
+			});
+		}
+		for (int k = 0; k < nthread; ++k) threads[k].join();
+		log.Flush();
+		elapsed = bench_now() - t0;
+	}
+
+	std::vector<int64_t> all;
+	for (int k = 0; k < nthread; ++k) all.insert(all.end(), cost[k].begin(), cost[k].end());
+	double mean(0.0);
+	for (size_t i = 0; i < all.size(); ++i) mean += all[i];
+	mean /= all.size();
+	double p50 = bench_percentile(all, 0.50);
+	double p99 = bench_percentile(all, 0.99);
+	printf("%-7s %8d %10.0f %10.0f %10.0f %12.0f\n", names[mode], nthread, mean, p50, p99,
+			all.size() / (elapsed * 1E-9));
+}
+
+int main(int argc, char** argv) {
+	int nthread = argc > 1 ? atoi(argv[1]) : 8;
+	int count = argc > 2 ? atoi(argv[2]) : 100000;
+	char tmpl[] = "/tmp/bench_glog.XXXXXX";
+	if (!mkdtemp(tmpl)) {
+		printf("failed to create temporary directory\n");
+		return 1;
+	}
+	std::string dir = std::string(tmpl) + "/";
+
+	printf("%-7s %8s %10s %10s %10s %12s\n", "mode", "threads", "mean(ns)", "p50(ns)", "p99(ns)", "lines/s");
+	run(dir, MODE_SYNC, nthread, count);
+	run(dir, MODE_ASYNC, nthread, count);
+	run(dir, MODE_BINARY, nthread, count);
+
+	std::string cmd = "rm -rf " + std::string(tmpl);
+	return system(cmd.c_str()) == 0 ? 0 : 1;
+}
@@ -0,0 +1,144 @@
+/**
+ * @file BenchIOServiceKeep.cpp 共享io_service线程池的性能测试
+ * @version 0.1
+ * @date 2026-10-16
+ * @note
+ * - 本机回环TCP, N个连接同时进行乒乓往返, 统计线程数、往返时间p50/p99和吞吐量
+ * - dedicated: 每个客户端独占一个AsioIOServiceKeep(一个线程), 即改造前的模型
+ * - shared:    全部客户端与服务器挂接进程内共享实例, 线程数为CPU核数
+ * - 用法: bench_iokeep [往返次数] [连接数...]. 缺省为100次, 10/100/1000个连接
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <vector>
+#include <boost/bind/bind.hpp>
+#include "../AsioTCP.h"
+#include "BenchUtil.h"
+
+using namespace boost::placeholders;
+
+class BenchEcho {
+protected:
+	struct Conn {
+		TcpCPtr client;
+		int remain;				///< 剩余往返次数
+		int64_t sent;			///< 发送时刻
+		std::vector<int64_t> rtt;	///< 往返时间
+	};
+
+	std::vector<Conn> conns_;
+	std::vector<TcpCPtr> accepted_;
+	boost::mutex mtx_;
+	std::atomic<int> connected_;
+	std::atomic<int> finished_;
+
+public:
+	/*!
+	 * @brief 运行一组测试
+	 * @param shared  使用共享实例
+	 * @param nconn   连接数
+	 * @param rounds  每个连接的往返次数
+	 * @param port    服务端口
+	 */
+	void Run(bool shared, int nconn, int rounds, uint16_t port) {
+		IOKeepPtr keep = shared ? AsioIOServiceKeep::Shared() : AsioIOServiceKeep::Create(1);
+		TcpSPtr server = TcpServer::Create(keep);
+		server->RegisterAccept(boost::bind(&BenchEcho::on_accept, this, _1, _2));
+		if (!server->CreateServer(port)) {
+			printf("failed to listen on port %u\n", port);
+			return;
+		}
+
+		connected_ = finished_ = 0;
+		conns_.clear();
+		conns_.resize(nconn);
+		for (int i = 0; i < nconn; ++i) {
+			Conn& conn = conns_[i];
+			conn.client = TcpClient::Create(shared ? keep : IOKeepPtr());
+			conn.remain = rounds;
+			conn.rtt.reserve(rounds);
+			conn.client->RegisterConnect(boost::bind(&BenchEcho::on_connect, this, _1, _2));
+			conn.client->RegisterRead(boost::bind(&BenchEcho::on_read, this, i, _1, _2));
+			conn.client->Connect("127.0.0.1", port);
+		}
+		wait(connected_, nconn);
+		int threads = bench_threads();
+
+		int64_t t0 = bench_now();
+		for (int i = 0; i < nconn; ++i) send(conns_[i]);
+		wait(finished_, nconn);
+		double dt = (bench_now() - t0) * 1E-9;
+
+		std::vector<int64_t> all;
+		for (int i = 0; i < nconn; ++i) all.insert(all.end(), conns_[i].rtt.begin(), conns_[i].rtt.end());
+		size_t n = all.size();
+		double p50 = bench_percentile(all, 0.50) * 1E-3;
+		double p99 = bench_percentile(all, 0.99) * 1E-3;
+		printf("%-9s %6d %8d %10.1f %10.1f %12.0f\n", shared ? "shared" : "dedicated",
+				nconn, threads, p50, p99, n / dt);
+
+		for (int i = 0; i < nconn; ++i) conns_[i].client->Close();
+		conns_.clear();
+		{
+			boost::mutex::scoped_lock lck(mtx_);
+			for (size_t i = 0; i < accepted_.size(); ++i) accepted_[i]->Close();
+			accepted_.clear();
+		}
+	}
+
+protected:
+	static void wait(std::atomic<int>& count, int n) {
+		for (int i = 0; i < 30000 && count.load() < n; ++i)
+			bench_sleep(1);
+	}
+
+	static void send(Conn& conn) {
+		conn.sent = bench_now();
+		conn.client->Write((const char*) &conn.sent, sizeof(conn.sent));
+	}
+
+	void on_accept(const TcpCPtr client, const TcpSPtr) {
+		client->RegisterRead(boost::bind(&BenchEcho::on_echo, this, _1, _2));
+		boost::mutex::scoped_lock lck(mtx_);
+		accepted_.push_back(client);
+	}
+
+	void on_echo(const TcpCPtr client, const error_code& ec) {
+		char buf[TCP_PACK_SIZE];
+		int n;
+		if (!ec && (n = client->Read(buf, sizeof(buf))) > 0) client->Write(buf, n);
+	}
+
+	void on_connect(const TcpCPtr, const error_code& ec) {
+		if (!ec) ++connected_;
+	}
+
+	void on_read(int i, const TcpCPtr client, const error_code& ec) {
+		Conn& conn = conns_[i];
+		int64_t stamp;
+		if (ec || client->Lookup() < int(sizeof(stamp))) return;
+		client->Read((char*) &stamp, sizeof(stamp));
+		conn.rtt.push_back(bench_now() - stamp);
+		if (--conn.remain > 0) send(conn);
+		else ++finished_;
+	}
+};
+
+int main(int argc, char** argv) {
+	int rounds = argc > 1 ? atoi(argv[1]) : 100;
+	std::vector<int> counts;
+	for (int i = 2; i < argc; ++i) counts.push_back(atoi(argv[i]));
+	if (counts.empty()) counts = { 10, 100, 1000 };
+
+	AsioIOServiceKeep::ConfigShared(0);
+	BenchEcho bench;
+	uint16_t port(41000);
+	printf("%-9s %6s %8s %10s %10s %12s\n", "mode", "conns", "threads", "p50(us)", "p99(us)", "rtt/s");
+	for (size_t i = 0; i < counts.size(); ++i) {
+		bench.Run(false, counts[i], rounds, port++);
+		bench.Run(true, counts[i], rounds, port++);
+	}
+	return 0;
+}
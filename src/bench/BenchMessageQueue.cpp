@@ -0,0 +1,107 @@
+/**
+ * @file BenchMessageQueue.cpp 消息队列后端的延迟与吞吐量测试
+ * @version 0.1
+ * @date 2026-10-16
+ * @note
+ * - MQ_IPC:    boost::interprocess::message_queue
+ * - MQ_INPROC: 进程内无锁队列
+ * - 延迟: 逐条投递, 前一条响应后投递下一条, 统计投递至响应的时间p50/p99
+ * - 吞吐量: producers个线程同时连续投递, 统计每秒响应的消息数量
+ * - 用法: bench_mq [消息数量]. 缺省为200000
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <boost/bind/bind.hpp>
+#include "../MessageQueue.h"
+#include "BenchUtil.h"
+
+using namespace boost::placeholders;
+
+class BenchQueue : public MessageQueue {
+public:
+	enum {
+		MSG_PING = MSG_USER	///< 参数1: 投递时刻
+	};
+
+	std::atomic<long> handled;		///< 已响应数量
+	std::vector<int64_t> latency;	///< 投递至响应的时间. 仅在延迟测试中记录
+	bool record;					///< 记录延迟
+
+public:
+	BenchQueue() {
+		handled = 0;
+		record  = false;
+	}
+
+protected:
+	void register_messages() {
+		RegisterMessage(MSG_PING, boost::bind(&BenchQueue::on_ping, this, _1, _2));
+	}
+
+	void on_ping(const long stamp, const long) {
+		if (record) latency.push_back(bench_now() - stamp);
+		handled.fetch_add(1, std::memory_order_release);
+	}
+};
+
+static void wait_handled(BenchQueue& queue, long n) {
+	while (queue.handled.load(std::memory_order_acquire) < n) std::this_thread::yield();
+}
+
+/*!
+ * @brief 运行一组测试
+ * @param backend   消息队列后端
+ * @param count     消息数量
+ * @param producers 吞吐量测试的投递线程数
+ */
+static void run(int backend, long count, int producers) {
+	BenchQueue queue;
+	if (!queue.Start("bench_mq", backend)) {
+		printf("failed to start queue: %s\n", queue.GetError());
+		return;
+	}
+
+	long rounds = count / 10;
+	queue.latency.reserve(rounds);
+	queue.record = true;
+	for (long i = 0; i < rounds; ++i) {
+		queue.PostMessage(BenchQueue::MSG_PING, long(bench_now()));
+		wait_handled(queue, i + 1);
+	}
+	queue.record = false;
+	double p50 = bench_percentile(queue.latency, 0.50) * 1E-3;
+	double p99 = bench_percentile(queue.latency, 0.99) * 1E-3;
+
+	long base = queue.handled.load();
+	long each = count / producers;
+	std::vector<std::thread> threads;
+	int64_t t0 = bench_now();
+	for (int k = 0; k < producers; ++k) {
+		threads.emplace_back([&queue, each]() {
+			for (long i = 0; i < each; ++i) queue.PostMessage(BenchQueue::MSG_PING, 0);
+		});
+	}
+	for (size_t k = 0; k < threads.size(); ++k) threads[k].join();
+	wait_handled(queue, base + each * producers);
+	double rate = each * producers / ((bench_now() - t0) * 1E-9);
+	queue.Stop();
+
+	printf("%-9s %10d %10.1f %10.1f %14.0f\n", backend == MessageQueue::MQ_IPC ? "ipc" : "inproc",
+			producers, p50, p99, rate);
+}
+
+int main(int argc, char** argv) {
+	long count = argc > 1 ? atol(argv[1]) : 200000;
+	int producers[] = { 1, 4 };
+
+	printf("%-9s %10s %10s %10s %14s\n", "backend", "producers", "p50(us)", "p99(us)", "msg/s");
+	for (size_t i = 0; i < sizeof(producers) / sizeof(producers[0]); ++i) {
+		run(MessageQueue::MQ_IPC, count, producers[i]);
+		run(MessageQueue::MQ_INPROC, count, producers[i]);
+	}
+	return 0;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file BenchUtil.h 性能测试的公共函数: 计时、分位数和线程数
+ * @version 0.1
+ * @date 2026-10-16
+ */
+
+#ifndef SRC_BENCH_BENCHUTIL_H_
+#define SRC_BENCH_BENCHUTIL_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+/*!
+ * @brief 单调时钟, 量纲: 纳秒
+ */
+inline int64_t bench_now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*!
+ * @brief 休眠
+ * @param ms 时长, 量纲: 毫秒
+ */
+inline void bench_sleep(int ms) {
+	std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+/*!
+ * @brief 分位数. 调用后samples被部分排序
+ * @param samples 样本
+ * @param q       分位, [0, 1]
+ */
+inline double bench_percentile(std::vector<int64_t>& samples, double q) {
+	if (samples.empty()) return 0.0;
+	size_t k = size_t(q * (samples.size() - 1) + 0.5);
+	std::nth_element(samples.begin(), samples.begin() + k, samples.end());
+	return double(samples[k]);
+}
+
+/*!
+ * @brief 进程当前的线程数. 非Linux系统返回-1
+ */
+inline int bench_threads() {
+	FILE* fp = fopen("/proc/self/status", "r");
+	char line[256];
+	int n(-1);
+	if (!fp) return -1;
+	while (fgets(line, sizeof(line), fp)) {
+		if (!strncmp(line, "Threads:", 8)) {
+			n = atoi(line + 8);
+			break;
+		}
+	}
+	fclose(fp);
+	return n;
+}
+
+#endif /* SRC_BENCH_BENCHUTIL_H_ */
@@ -13,11 +13,12 @@
 #include "AsioUDP.h"
 
 int main(int argc, char **argv) {
-	AsioUDP server;
-	AsioUDP udp;
-	server.Open(3000);
-	udp.Open();
-	udp.WriteTo("192.168.10.12", 3000, "hello", 5);
+	IOKeepPtr keep = AsioIOServiceKeep::Shared();
+	UdpCPtr server = AsioUDP::Create(keep);
+	UdpCPtr udp = AsioUDP::Create(keep);
+	server->Open(3000);
+	udp->Open();
+	udp->WriteTo("192.168.10.12", 3000, "hello", 5);
 	sleep(5);
 
 //	ats.SetUTC(2028, 11, 13, 0.2);
@@ -0,0 +1,112 @@
+/**
+ * @file TestByteRing.cpp ByteRing的单元测试
+ * @version 0.1
+ * @date 2026-10-16
+ */
+
+#include <string>
+#include <boost/test/unit_test.hpp>
+#include "../ByteRing.h"
+
+static const size_t npos = ByteRing::npos;	// 按值比较, 避免ODR使用类内常量
+
+static std::string ring_str(const ByteRing& ring) {
+	std::string s(ring.size(), 0);
+	ring.copy(&s[0], s.size());
+	return s;
+}
+
+BOOST_AUTO_TEST_SUITE(ByteRingTest)
+
+BOOST_AUTO_TEST_CASE(push_copy_wrap) {
+	ByteRing ring(8);
+	ring.push_back("abcdef", 6);
+	ring.erase_begin(4);
+	ring.push_back("ghijk", 5);		// 跨越存储区尾部
+	BOOST_CHECK_EQUAL(ring.size(), 7u);
+	BOOST_CHECK_EQUAL(ring_str(ring), "efghijk");
+	BOOST_CHECK_EQUAL(ring.array_one().second + ring.array_two().second, 7u);
+	BOOST_CHECK(ring.array_two().second > 0);
+	BOOST_CHECK_EQUAL(ring[0], 'e');
+	BOOST_CHECK_EQUAL(ring[6], 'k');
+	BOOST_CHECK_EQUAL(ring.offset(), 4u);
+
+	char out[4];
+	BOOST_CHECK_EQUAL(ring.copy(out, 4, 2), 4u);
+	BOOST_CHECK_EQUAL(std::string(out, 4), "ghij");
+}
+
+BOOST_AUTO_TEST_CASE(overwrite_oldest) {
+	ByteRing ring(8);
+	ring.push_back("abcdef", 6);
+	ring.push_back("ghij", 4);		// 覆盖最早的2字节
+	BOOST_CHECK(ring.full());
+	BOOST_CHECK_EQUAL(ring_str(ring), "cdefghij");
+	BOOST_CHECK_EQUAL(ring.offset(), 2u);
+
+	ring.push_back("0123456789", 10);	// 单次写入超出容量: 仅保留最后8字节
+	BOOST_CHECK_EQUAL(ring_str(ring), "23456789");
+	BOOST_CHECK_EQUAL(ring.offset(), 12u);	// 累计写入20字节
+}
+
+BOOST_AUTO_TEST_CASE(range_views) {
+	ByteRing ring(8);
+	ByteRing::array_range one, two;
+	ring.push_back("abcdef", 6);
+	ring.erase_begin(5);
+	ring.push_back("ghijk", 5);
+	ring.range(1, 4, one, two);
+	BOOST_CHECK_EQUAL(std::string(one.first, one.second) + std::string(two.first, two.second), "ghij");
+}
+
+BOOST_AUTO_TEST_CASE(find_single_and_multi) {
+	ByteRing ring(16);
+	ring.push_back("xxxxxxxxxx", 10);
+	ring.erase_begin(10);
+	ring.push_back("abc\r\ndef\r\n", 10);	// 跨越存储区尾部
+	BOOST_CHECK_EQUAL(ring.find("\n", 1), 4u);
+	BOOST_CHECK_EQUAL(ring.find("\r\n", 2), 3u);
+	BOOST_CHECK_EQUAL(ring.find("\r\n", 2, 4), 8u);
+	BOOST_CHECK_EQUAL(ring.find("zz", 2), npos);
+	BOOST_CHECK_EQUAL(ring.find("def\r\n", 5), 5u);
+}
+
+BOOST_AUTO_TEST_CASE(find_across_joint) {
+	ByteRing ring(8);
+	ring.push_back("abcdef", 6);
+	ring.erase_begin(6);
+	ring.push_back("xy$$zw", 6);	// "$$"位于存储区尾部与首部之间
+	BOOST_CHECK_EQUAL(ring.find("$$", 2), 2u);
+	BOOST_CHECK_EQUAL(ring.find("y$$z", 4), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(find_incremental) {
+	ByteRing ring(32);
+	ring.push_back("abcdefgh", 8);
+	BOOST_CHECK_EQUAL(ring.find("\n", 1), npos);
+	ring.push_back("ij\nkl", 5);
+	BOOST_CHECK_EQUAL(ring.find("\n", 1), 10u);
+	ring.erase_begin(11);
+	BOOST_CHECK_EQUAL(ring.find("\n", 1), npos);
+	ring.push_back("m\n", 2);
+	BOOST_CHECK_EQUAL(ring.find("\n", 1), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(find_after_full_overwrite) {
+	ByteRing ring(8);
+	ring.push_back("abcde", 5);
+	BOOST_CHECK_EQUAL(ring.find("\n", 1), npos);
+	ring.push_back("xyz\nQRSTUV", 10);	// 替换全部数据, 查找缓存不得跳过新数据
+	BOOST_CHECK_EQUAL(ring_str(ring), "z\nQRSTUV");
+	BOOST_CHECK_EQUAL(ring.find("\n", 1), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(search_bmh) {
+	const char text[] = "the quick brown fox jumps over the lazy dog";
+	BOOST_CHECK_EQUAL(ByteRing::search(text, sizeof(text) - 1, "lazy", 4), 35u);
+	BOOST_CHECK_EQUAL(ByteRing::search(text, sizeof(text) - 1, "the", 3), 0u);
+	BOOST_CHECK_EQUAL(ByteRing::search(text, sizeof(text) - 1, "cat", 3), npos);
+	BOOST_CHECK_EQUAL(ByteRing::search(text, 3, "the quick", 9), npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,54 @@
+/**
+ * @file TestCallback.cpp Callback的单元测试
+ * @version 0.1
+ * @date 2026-10-17
+ */
+
+#include <atomic>
+#include <thread>
+#include <boost/test/unit_test.hpp>
+#include "../Callback.h"
+
+BOOST_AUTO_TEST_SUITE(CallbackTest)
+
+BOOST_AUTO_TEST_CASE(connect_replace_disconnect) {
+	Callback<void (int)> cb;
+	int a(0), b(0);
+	BOOST_CHECK(cb.empty());
+	cb(1);		// 未设置插槽: 无操作
+
+	cb.connect([&a](int x) { a += x; });
+	BOOST_CHECK(!cb.empty());
+	cb(2);
+	cb.connect([&b](int x) { b += x; });	// 替换
+	cb(3);
+	BOOST_CHECK_EQUAL(a, 2);
+	BOOST_CHECK_EQUAL(b, 3);
+
+	cb.disconnect_all_slots();
+	BOOST_CHECK(cb.empty());
+	cb(4);
+	cb.connect(Callback<void (int)>::slot_type());	// 空插槽等同清除
+	BOOST_CHECK(cb.empty());
+	BOOST_CHECK_EQUAL(b, 3);
+}
+
+BOOST_AUTO_TEST_CASE(replace_while_emitting) {
+	Callback<void (int)> cb;
+	std::atomic<long> sum(0);
+	std::atomic<bool> stop(false);
+	cb.connect([&sum](int x) { sum.fetch_add(x); });
+
+	std::thread emitter([&]() {
+		while (!stop.load()) cb(1);
+	});
+	for (int i = 0; i < 1000; ++i) {// 触发期间替换, 被替换的插槽不得提前释放
+		if (i % 2) cb.connect([&sum](int x) { sum.fetch_add(x); });
+		else cb.disconnect_all_slots();
+	}
+	stop = true;
+	emitter.join();
+	BOOST_CHECK(sum.load() >= 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,75 @@
+/**
+ * @file TestGLogBinary.cpp 二进制日志编码与GLog::Decode()的单元测试
+ * @version 0.1
+ * @date 2026-10-16
+ */
+
+#include <stdio.h>
+#include <string>
+#include <boost/test/unit_test.hpp>
+#include "../GLog.h"
+#include "TestUtil.h"
+
+/*!
+ * @brief 记录二进制日志后还原为文本
+ * @param async 以异步模式记录
+ * @param text  还原的文本
+ * @return
+ * 还原的日志行数
+ */
+static int bin_round_trip(bool async, std::string& text) {
+	TestDir dir;
+	{
+		GLog log(dir.Path().c_str(), "bin");
+		if (async) log.StartAsync();
+		log.SetBinary(true);
+		std::string name("M31");
+		GLOG_BIN(log, "camera", LOG_NORMAL, "exposure %d of %s: %.2f s, gain %u", 5, name, 1.5, 3u);
+		GLOG_BIN(log, NULL, LOG_WARN, "temperature %.1f", -20.25);
+		log.Write("mount", LOG_NORMAL, "plain text %d", 7);	// 二进制模式下的文本记录
+		log.Flush();
+	}
+
+	std::string path = test_find(dir.Path(), ".blog");
+	BOOST_REQUIRE(!path.empty());
+	FILE* out = tmpfile();
+	BOOST_REQUIRE(out);
+	int n = GLog::Decode(path.c_str(), out, 3);
+	text = test_read(out);
+	fclose(out);
+	return n;
+}
+
+BOOST_AUTO_TEST_SUITE(GLogBinaryTest)
+
+BOOST_AUTO_TEST_CASE(decode_sync) {
+	std::string text;
+	BOOST_CHECK_EQUAL(bin_round_trip(false, text), 3);
+	BOOST_CHECK(text.find("camera") != std::string::npos);
+	BOOST_CHECK(text.find("exposure 5 of M31: 1.50 s, gain 3") != std::string::npos);
+	BOOST_CHECK(text.find("temperature -20.2") != std::string::npos);
+	BOOST_CHECK(text.find("plain text 7") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(decode_async) {
+	std::string text;
+	BOOST_CHECK_EQUAL(bin_round_trip(true, text), 3);
+	BOOST_CHECK(text.find("exposure 5 of M31: 1.50 s, gain 3") != std::string::npos);
+	BOOST_CHECK(text.find("plain text 7") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(decode_text_mode) {
+	TestDir dir;
+	{
+		GLog log(dir.Path().c_str(), "text");
+		GLOG_BIN(log, "camera", LOG_NORMAL, "frame %d", 9);	// 非二进制模式: 即时生成文本
+	}
+	std::vector<std::string> lines = test_lines(test_find(dir.Path(), ".log"));
+	bool found(false);
+	for (size_t i = 0; i < lines.size(); ++i) found |= lines[i].find("frame 9") != std::string::npos;
+	BOOST_CHECK(found);
+	BOOST_CHECK(test_find(dir.Path(), ".blog").empty());
+	BOOST_CHECK_EQUAL(GLog::Decode((dir.Path() + "none.blog").c_str(), stdout), -1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,135 @@
+/**
+ * @file TestGLogIndex.cpp GLogIndex及GLog::Query()的单元测试
+ * @version 0.1
+ * @date 2026-10-16
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <string>
+#include <boost/test/unit_test.hpp>
+#include "../GLog.h"
+#include "TestUtil.h"
+
+/*!
+ * @class TestArchiver 开放压缩接口的归档器
+ */
+class TestArchiver : public GLogArchiver {
+public:
+	using GLogArchiver::gzip;
+};
+
+BOOST_AUTO_TEST_SUITE(GLogIndexTest)
+
+BOOST_AUTO_TEST_CASE(write_and_load) {
+	TestDir dir;
+	std::string path = dir.Path() + "a.log.idx";
+	GLogIndexWriter writer;
+	BOOST_REQUIRE(writer.Open(path, 60, 0));
+	writer.Line(120, "focus", 0);
+	writer.Line(130, "mount", 10);
+	writer.Line(150, "focus", 20);	// 同一分桶仅记录一次
+	writer.Line(185, "focus", 30);
+	writer.Line(190, NULL, 40);
+	writer.Close();
+
+	BOOST_REQUIRE(writer.Open(path, 60, 50));	// 新会话: 标签重新编号
+	writer.Line(300, "mount", 50);
+	writer.Close();
+
+	GLogIndexReader reader;
+	BOOST_REQUIRE(reader.Load(path.c_str()));
+	BOOST_REQUIRE_EQUAL(reader.buckets.size(), 3u);
+	BOOST_CHECK_EQUAL(reader.buckets[0].start, 120);
+	BOOST_CHECK_EQUAL(reader.buckets[0].width, 60);
+	BOOST_CHECK_EQUAL(reader.buckets[1].start, 180);
+	BOOST_CHECK_EQUAL(reader.buckets[1].offset, 30u);
+	BOOST_CHECK_EQUAL(reader.buckets[2].offset, 50u);
+
+	BOOST_REQUIRE_EQUAL(reader.tags["focus"].size(), 2u);
+	BOOST_CHECK_EQUAL(reader.tags["focus"][1], 30u);
+	BOOST_REQUIRE_EQUAL(reader.tags["mount"].size(), 2u);
+	BOOST_CHECK_EQUAL(reader.tags["mount"][0], 0u);
+	BOOST_CHECK_EQUAL(reader.tags["mount"][1], 50u);
+
+	BOOST_CHECK(!reader.Load((dir.Path() + "none.idx").c_str()));
+}
+
+BOOST_AUTO_TEST_CASE(glog_query) {
+	TestDir dir;
+	{
+		GLog log(dir.Path().c_str(), "query");
+		log.SetIndex(1);
+		for (int i = 0; i < 6; ++i) log.Write(i % 3 ? "mount" : "focus", LOG_NORMAL, "line %d", i);
+		log.Flush();
+	}
+
+	std::string path = test_find(dir.Path(), ".log");
+	BOOST_REQUIRE(!path.empty());
+	BOOST_CHECK(!test_find(dir.Path(), ".log.idx").empty());
+
+	FILE* out = tmpfile();
+	BOOST_REQUIRE(out);
+	BOOST_CHECK_EQUAL(GLog::Query(path.c_str(), out, 0, 0, "focus"), 2);
+	std::string text = test_read(out);
+	BOOST_CHECK(text.find("line 0") != std::string::npos);
+	BOOST_CHECK(text.find("line 3") != std::string::npos);
+	BOOST_CHECK(text.find("line 1") == std::string::npos);
+	fclose(out);
+
+	out = tmpfile();
+	std::time_t now = std::time(NULL);
+	BOOST_CHECK_EQUAL(GLog::Query(path.c_str(), out, now - 3600, 0, "mount"), 4);
+	BOOST_CHECK_EQUAL(GLog::Query(path.c_str(), out, now + 3600, 0), 0);
+	fclose(out);
+
+	BOOST_CHECK_EQUAL(GLog::Query((dir.Path() + "none.log").c_str(), stdout, 0, 0), -1);
+}
+
+BOOST_AUTO_TEST_CASE(glog_query_archived) {
+	TestDir dir;
+	std::string path = dir.Path() + "arch20260101.log";
+	const std::time_t day = 1767225600;	// 2026-01-01 UTC
+	FILE* fp = fopen(path.c_str(), "wb");
+	BOOST_REQUIRE(fp);
+	GLogIndexWriter writer;
+	BOOST_REQUIRE(writer.Open(path + ".idx", 10, 0));
+	for (int i = 0; i < 4000; ++i) {// 约400KB, 每10秒一个分桶
+		int sec = i / 10;
+		const char* where = i % 4 ? "mount" : "focus";
+		writer.Line(day + sec, where, uint64_t(ftell(fp)));
+		fprintf(fp, "%02d:%02d:%02d >> %s, line %04d %s\n", sec / 3600, sec / 60 % 60, sec % 60,
+				where, i, std::string(60, 'x').c_str());
+	}
+	fclose(fp);
+	writer.Close();
+
+	FILE* out = tmpfile();
+	BOOST_REQUIRE(out);
+	int plain = GLog::Query(path.c_str(), out, day + 250, day + 300, "focus");
+	std::string expect = test_read(out);
+	fclose(out);
+	BOOST_CHECK_EQUAL(plain, 125);
+
+	TestArchiver archiver;
+	BOOST_REQUIRE(archiver.gzip(path));
+	BOOST_CHECK(access(path.c_str(), F_OK));
+	GLogIndexReader index;
+	BOOST_REQUIRE(index.Load((path + ".idx").c_str()));
+	BOOST_REQUIRE(index.members.size() > 1);	// 分段压缩
+	BOOST_CHECK_EQUAL(index.members[0].offset, 0u);
+	BOOST_CHECK_EQUAL(index.members[0].zoffset, 0u);
+	for (size_t i = 1; i < index.members.size(); ++i) {
+		BOOST_CHECK(index.members[i].offset - index.members[i - 1].offset >= GLOG_GZ_MEMBER);
+		BOOST_CHECK(index.members[i].zoffset > index.members[i - 1].zoffset);
+	}
+
+	out = tmpfile();
+	BOOST_REQUIRE(out);
+	BOOST_CHECK_EQUAL(GLog::Query((path + ".gz").c_str(), out, day + 250, day + 300, "focus"), plain);
+	BOOST_CHECK_EQUAL(test_read(out), expect);
+	BOOST_CHECK_EQUAL(GLog::Query((path + ".gz").c_str(), out, 0, 0), 4000);	// 跨越全部成员
+	fclose(out);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
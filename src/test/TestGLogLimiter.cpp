@@ -0,0 +1,127 @@
+/**
+ * @file TestGLogLimiter.cpp GLogLimiter及GLog限流的单元测试
+ * @version 0.1
+ * @date 2026-10-16
+ */
+
+#include <string>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include "../GLog.h"
+#include "TestUtil.h"
+
+BOOST_AUTO_TEST_SUITE(GLogLimiterTest)
+
+BOOST_AUTO_TEST_CASE(disabled) {
+	GLogLimiter limiter;
+	uint32_t folded;
+	BOOST_CHECK(!limiter.Enabled());
+	for (int i = 0; i < 100; ++i) BOOST_CHECK(limiter.Admit("fmt", NULL, 0, 0, folded));
+	limiter.Set(10, 3);
+	BOOST_CHECK(limiter.Enabled());
+	limiter.Set(0, 3);
+	BOOST_CHECK(!limiter.Enabled());
+}
+
+BOOST_AUTO_TEST_CASE(burst_and_fold) {
+	GLogLimiter limiter;
+	const int64_t sec = 1000000000, t0 = 100 * sec, interval = sec / 10;
+	static const char key[] = "fmt";
+	uint32_t folded;
+	limiter.Set(10, 3);
+
+	for (int i = 0; i < 3; ++i) BOOST_CHECK(limiter.Admit(key, "cam", 1, t0, folded));	// 突发
+	BOOST_CHECK(!limiter.Admit(key, "cam", 1, t0, folded));
+	BOOST_CHECK(!limiter.Admit(key, "cam", 1, t0 + interval / 2, folded));
+	BOOST_CHECK(limiter.Admit(key, "cam", 1, t0 + interval, folded));
+	BOOST_CHECK_EQUAL(folded, 2u);
+
+	static const char other[] = "other";	// 调用点相互独立
+	BOOST_CHECK(limiter.Admit(other, NULL, 1, t0 + interval, folded));
+	BOOST_CHECK_EQUAL(folded, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(shared_format) {
+	GLogLimiter limiter;
+	static const char key[] = "%s";
+	uint32_t folded;
+	limiter.Set(1, 1);
+
+	BOOST_CHECK(limiter.Admit(key, "camera", 1, 0, folded));
+	BOOST_CHECK(!limiter.Admit(key, "camera", 1, 0, folded));
+	BOOST_CHECK(limiter.Admit(key, "mount", 1, 0, folded));		// 同一格式, 不同位置
+	BOOST_CHECK(limiter.Admit(key, "camera", 2, 0, folded));	// 同一格式, 不同类型
+	BOOST_CHECK(limiter.Admit(key, NULL, 1, 0, folded));
+	BOOST_CHECK(!limiter.Admit(key, NULL, 1, 0, folded));
+}
+
+BOOST_AUTO_TEST_CASE(collect) {
+	GLogLimiter limiter;
+	static const char key[] = "fmt";
+	std::vector<std::string> wheres;
+	std::vector<uint32_t> counts;
+	uint32_t folded;
+	limiter.Set(1, 1);
+	for (int i = 0; i < 5; ++i) limiter.Admit(key, "mount", 2, 0, folded);
+
+	limiter.Collect([&](const char* where, int type, uint32_t n) {
+		wheres.push_back(where ? where : "");
+		counts.push_back(n);
+		BOOST_CHECK_EQUAL(type, 2);
+	});
+	BOOST_REQUIRE_EQUAL(counts.size(), 1u);
+	BOOST_CHECK_EQUAL(wheres[0], "mount");
+	BOOST_CHECK_EQUAL(counts[0], 4u);
+
+	counts.clear();
+	limiter.Collect([&](const char*, int, uint32_t n) { counts.push_back(n); });
+	BOOST_CHECK(counts.empty());	// 已取出
+}
+
+BOOST_AUTO_TEST_CASE(glog_rate_limit) {
+	TestDir dir;
+	{
+		GLog log(dir.Path().c_str(), "limit");
+		log.SetRateLimit(1, 2);
+		for (int i = 0; i < 10; ++i) log.Write("focus", LOG_NORMAL, "position %d", i);
+		log.Flush();
+	}
+
+	std::vector<std::string> lines = test_lines(test_find(dir.Path(), ".log"));
+	int written(0), repeated(0);
+	for (size_t i = 0; i < lines.size(); ++i) {
+		if (lines[i].find("position") != std::string::npos) ++written;
+		if (lines[i].find("last message repeated 8 times") != std::string::npos) ++repeated;
+	}
+	BOOST_CHECK_EQUAL(written, 2);
+	BOOST_CHECK_EQUAL(repeated, 1);
+}
+
+BOOST_AUTO_TEST_CASE(glog_write_lines_unlimited) {
+	TestDir dir;
+	std::string report;
+	for (int i = 0; i < 20; ++i) report += "row " + std::to_string(i) + "\n";
+	{
+		GLog log(dir.Path().c_str(), "lines");
+		log.SetRateLimit(1, 2);
+		log.WriteLines("stats", LOG_NORMAL, report.c_str());
+		log.Write("stats", LOG_NORMAL, "%s", "first");
+		log.Write("other", LOG_NORMAL, "%s", "second");	// 共用格式的其它位置不受影响
+		log.Flush();
+	}
+
+	std::vector<std::string> lines = test_lines(test_find(dir.Path(), ".log"));
+	int rows(0), first(0), second(0), repeated(0);
+	for (size_t i = 0; i < lines.size(); ++i) {
+		if (lines[i].find("row ") != std::string::npos) ++rows;
+		if (lines[i].find("first") != std::string::npos) ++first;
+		if (lines[i].find("second") != std::string::npos) ++second;
+		if (lines[i].find("repeated") != std::string::npos) ++repeated;
+	}
+	BOOST_CHECK_EQUAL(rows, 20);
+	BOOST_CHECK_EQUAL(first, 1);
+	BOOST_CHECK_EQUAL(second, 1);
+	BOOST_CHECK_EQUAL(repeated, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
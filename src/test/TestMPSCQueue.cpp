@@ -0,0 +1,73 @@
+/**
+ * @file TestMPSCQueue.cpp MPSCQueue的单元测试
+ * @version 0.1
+ * @date 2026-10-16
+ */
+
+#include <thread>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include "../MPSCQueue.h"
+
+BOOST_AUTO_TEST_SUITE(MPSCQueueTest)
+
+BOOST_AUTO_TEST_CASE(capacity_and_fifo) {
+	MPSCQueue<int> queue(5);
+	int x;
+	BOOST_CHECK_EQUAL(queue.capacity(), 8u);
+	BOOST_CHECK(!queue.pop(x));
+
+	for (int i = 0; i < 8; ++i) BOOST_CHECK(queue.push(i));
+	BOOST_CHECK(!queue.push(8));		// 队列已满
+	BOOST_CHECK_EQUAL(queue.size_approx(), 8u);
+	BOOST_CHECK_EQUAL(*queue.front(), 0);
+
+	for (int i = 0; i < 8; ++i) {
+		BOOST_REQUIRE(queue.pop(x));
+		BOOST_CHECK_EQUAL(x, i);
+	}
+	BOOST_CHECK(!queue.pop(x));
+	BOOST_CHECK(queue.front() == NULL);
+}
+
+BOOST_AUTO_TEST_CASE(emplace_in_place) {
+	MPSCQueue<std::vector<int> > queue(4);
+	std::vector<int> v;
+	BOOST_CHECK(queue.emplace([](std::vector<int>& data) { data.assign(3, 7); }));
+	BOOST_REQUIRE(queue.pop(v));
+	BOOST_CHECK_EQUAL(v.size(), 3u);
+	BOOST_CHECK_EQUAL(v[2], 7);
+}
+
+BOOST_AUTO_TEST_CASE(multi_producer) {
+	const int producers = 4, count = 50000;
+	MPSCQueue<long> queue(256);
+	std::vector<std::thread> threads;
+	for (int k = 0; k < producers; ++k) {
+		threads.emplace_back([&queue, k]() {
+			for (long i = 0; i < count; ++i) {
+				while (!queue.push(long(k) << 32 | i)) std::this_thread::yield();
+			}
+		});
+	}
+
+	std::vector<long> next(producers, 0);
+	long x, total(0);
+	bool ordered(true);
+	while (total < long(producers) * count) {
+		if (!queue.pop(x)) {
+			std::this_thread::yield();
+			continue;
+		}
+		int k = int(x >> 32);
+		if ((x & 0xFFFFFFFF) != next[k]) ordered = false;	// 同一生产者的元素保持顺序
+		next[k] = (x & 0xFFFFFFFF) + 1;
+		++total;
+	}
+	for (size_t k = 0; k < threads.size(); ++k) threads[k].join();
+	BOOST_CHECK(ordered);
+	for (int k = 0; k < producers; ++k) BOOST_CHECK_EQUAL(next[k], count);
+	BOOST_CHECK(!queue.pop(x));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,132 @@
+/**
+ * @file TestMQTimerWheel.cpp MQTimerWheel的单元测试
+ * @version 0.1
+ * @date 2026-10-16
+ * @note
+ * 以显式刻度推进时间轮, 结果与系统时钟无关
+ */
+
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include "../MQTimerWheel.h"
+
+/*!
+ * @class TestWheel 可按指定刻度推进的时间轮
+ */
+class TestWheel : public MQTimerWheel<int> {
+public:
+	std::vector<int> fired;			///< 触发的定时器数据
+	std::vector<uint64_t> ticks;	///< 触发时的刻度
+
+public:
+	TestWheel(uint32_t capacity = 64) : MQTimerWheel<int>(capacity) {
+		poller() = this;	// 测试线程即消息队列线程
+	}
+
+	/*!
+	 * @brief 处理请求并推进至刻度target
+	 */
+	void Run(uint64_t target) {
+		drain();
+		advance(target, *this);
+	}
+
+	uint32_t Pending() const {
+		return pending_;
+	}
+
+	void operator()(const int& data) {
+		fired.push_back(data);
+		ticks.push_back(now_);
+	}
+};
+
+BOOST_AUTO_TEST_SUITE(MQTimerWheelTest)
+
+BOOST_AUTO_TEST_CASE(one_shot) {
+	TestWheel wheel;
+	BOOST_CHECK(wheel.NextTick() == TestWheel::never);
+	BOOST_CHECK(wheel.Add(1, 5, 0));
+	BOOST_CHECK(wheel.Add(2, 3, 0));
+	wheel.Run(4);
+	BOOST_REQUIRE_EQUAL(wheel.fired.size(), 1u);
+	BOOST_CHECK_EQUAL(wheel.fired[0], 2);
+	BOOST_CHECK_EQUAL(wheel.ticks[0], 3u);
+	BOOST_CHECK_EQUAL(wheel.NextTick(), 5u);
+
+	wheel.Run(5);
+	BOOST_REQUIRE_EQUAL(wheel.fired.size(), 2u);
+	BOOST_CHECK_EQUAL(wheel.fired[1], 1);
+	BOOST_CHECK_EQUAL(wheel.Pending(), 0u);
+	BOOST_CHECK(wheel.NextTick() == TestWheel::never);
+}
+
+BOOST_AUTO_TEST_CASE(expired_fires_next_tick) {
+	TestWheel wheel;
+	wheel.Add(1, 1000, 0);
+	wheel.Run(100);
+	wheel.Add(7, 20, 0);		// 到期刻度已过: 在下一刻度触发
+	wheel.Run(101);
+	BOOST_REQUIRE_EQUAL(wheel.fired.size(), 1u);
+	BOOST_CHECK_EQUAL(wheel.ticks[0], 101u);
+}
+
+BOOST_AUTO_TEST_CASE(periodic_and_cancel) {
+	TestWheel wheel;
+	uint64_t handle = wheel.Add(3, 10, 10);
+	wheel.Run(35);
+	BOOST_REQUIRE_EQUAL(wheel.ticks.size(), 3u);
+	BOOST_CHECK_EQUAL(wheel.ticks[0], 10u);
+	BOOST_CHECK_EQUAL(wheel.ticks[2], 30u);
+
+	wheel.Cancel(handle);
+	wheel.Run(100);
+	BOOST_CHECK_EQUAL(wheel.ticks.size(), 3u);
+	BOOST_CHECK_EQUAL(wheel.Pending(), 0u);
+
+	wheel.Cancel(handle);		// 重复取消被忽略
+	uint64_t again = wheel.Add(4, 110, 0);
+	BOOST_CHECK(again != handle);	// 节点复用后版本号不同
+	wheel.Cancel(handle);
+	wheel.Run(110);
+	BOOST_CHECK_EQUAL(wheel.fired.back(), 4);
+}
+
+BOOST_AUTO_TEST_CASE(cascade_levels) {
+	TestWheel wheel;
+	const uint64_t expires[] = { 300, 70000, 20000000 };	// 第1、2、3层
+	for (int i = 0; i < 3; ++i) wheel.Add(i, expires[i], 0);
+	wheel.Run(0);
+	BOOST_CHECK_EQUAL(wheel.NextTick(), 256u);	// 第1层槽位降级时刻
+
+	wheel.Run(299);
+	BOOST_CHECK(wheel.fired.empty());
+	wheel.Run(69999);
+	BOOST_REQUIRE_EQUAL(wheel.ticks.size(), 1u);
+	BOOST_CHECK_EQUAL(wheel.ticks[0], 300u);
+	wheel.Run(19999999);
+	BOOST_REQUIRE_EQUAL(wheel.ticks.size(), 2u);
+	BOOST_CHECK_EQUAL(wheel.ticks[1], 70000u);
+	wheel.Run(20000000);
+	BOOST_REQUIRE_EQUAL(wheel.ticks.size(), 3u);
+	BOOST_CHECK_EQUAL(wheel.ticks[2], 20000000u);
+}
+
+BOOST_AUTO_TEST_CASE(poller_drains_full_queue) {
+	TestWheel wheel(16);	// 请求队列容量32
+	std::vector<uint64_t> handles;
+	for (int round = 0; round < 8; ++round) {// 消息队列线程连续请求, 不得等待自身
+		for (int i = 0; i < 16; ++i) {
+			uint64_t handle = wheel.Add(i, 1000, 0);
+			BOOST_REQUIRE(handle);
+			handles.push_back(handle);
+		}
+		for (size_t i = 0; i < handles.size(); ++i) wheel.Cancel(handles[i]);
+		handles.clear();
+	}
+	wheel.Run(1000);
+	BOOST_CHECK(wheel.fired.empty());
+	BOOST_CHECK_EQUAL(wheel.Pending(), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
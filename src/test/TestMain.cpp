@@ -0,0 +1,11 @@
+/**
+ * @file TestMain.cpp 单元测试入口. 各组件的测试用例位于同目录的Test*.cpp
+ * @version 0.1
+ * @date 2026-10-16
+ * @note
+ * - 基于Boost.Test(仅头文件形式), 无需链接测试库
+ * - 运行: make check, 或直接执行lxmlib_test
+ */
+
+#define BOOST_TEST_MODULE lxmlib
+#include <boost/test/included/unit_test.hpp>
@@ -0,0 +1,132 @@
+/**
+ * @file TestMessageQueue.cpp MessageQueue的单元测试
+ * @version 0.1
+ * @date 2026-10-17
+ */
+
+#include <atomic>
+#include <map>
+#include <thread>
+#include <boost/bind/bind.hpp>
+#include <boost/test/unit_test.hpp>
+#include "../MessageQueue.h"
+
+using namespace boost::placeholders;
+
+/*!
+ * @class TestQueue 响应线程可被阻塞的消息队列
+ */
+class TestQueue : public MessageQueue {
+public:
+	enum {
+		MSG_GATE = MSG_USER,	///< 阻塞响应线程, 直至open置位
+		MSG_TEMP,				///< 参数1: 设备编号; 参数2: 温度
+		MSG_BLOB				///< 大负载. 首条消息阻塞响应线程, 直至open置位
+	};
+
+	std::atomic<bool> open;		///< 放行
+	std::atomic<bool> blocked;	///< 响应线程已阻塞
+	std::atomic<int> handled;	///< MSG_TEMP响应次数
+	std::atomic<int> blobs;		///< MSG_BLOB响应次数
+	std::map<long, long> temp;	///< 各设备最近的温度
+
+public:
+	TestQueue() {
+		open    = false;
+		blocked = false;
+		handled = 0;
+		blobs   = 0;
+	}
+
+	void Wait(int n) {
+		while (handled.load() < n) std::this_thread::yield();
+	}
+
+protected:
+	void register_messages() {
+		RegisterMessage(MSG_GATE, boost::bind(&TestQueue::on_gate, this, _1, _2));
+		RegisterMessage(MSG_TEMP, boost::bind(&TestQueue::on_temp, this, _1, _2));
+		RegisterPayload(MSG_BLOB, boost::bind(&TestQueue::on_blob, this, _1, _2, _3));
+	}
+
+	void on_gate(const long, const long) {
+		blocked = true;
+		while (!open.load()) std::this_thread::yield();
+	}
+
+	void on_temp(const long device, const long value) {
+		temp[device] = value;
+		handled.fetch_add(1);
+	}
+
+	void on_blob(const long, const long, const MQPayload&) {
+		on_gate(0, 0);
+		blobs.fetch_add(1);
+	}
+};
+
+BOOST_AUTO_TEST_SUITE(MessageQueueTest)
+
+BOOST_AUTO_TEST_CASE(coalesce_per_par1) {
+	TestQueue queue;
+	BOOST_REQUIRE(queue.SetWorkers(0, MessageQueue::SHARD_PAR1));
+	BOOST_REQUIRE(queue.SetCoalescing(TestQueue::MSG_TEMP));
+	BOOST_REQUIRE(queue.Start("test_mq", MessageQueue::MQ_INPROC));
+
+	queue.PostMessage(TestQueue::MSG_GATE);
+	while (!queue.blocked.load()) std::this_thread::yield();
+	queue.PostMessage(TestQueue::MSG_TEMP, 1, 10);
+	queue.PostMessage(TestQueue::MSG_TEMP, 2, 20);	// 不替换设备1的消息
+	queue.PostMessage(TestQueue::MSG_TEMP, 1, 11);	// 替换设备1的消息
+	queue.open = true;
+	queue.Wait(2);
+	queue.Stop();
+
+	BOOST_CHECK_EQUAL(queue.handled.load(), 2);
+	BOOST_CHECK_EQUAL(queue.temp[1], 11);
+	BOOST_CHECK_EQUAL(queue.temp[2], 20);
+}
+
+BOOST_AUTO_TEST_CASE(coalesce_per_id) {
+	TestQueue queue;
+	BOOST_REQUIRE(queue.SetCoalescing(TestQueue::MSG_TEMP));
+	BOOST_REQUIRE(queue.Start("test_mq", MessageQueue::MQ_INPROC));
+
+	queue.PostMessage(TestQueue::MSG_GATE);
+	while (!queue.blocked.load()) std::this_thread::yield();
+	queue.PostMessage(TestQueue::MSG_TEMP, 1, 10);
+	queue.PostMessage(TestQueue::MSG_TEMP, 2, 20);	// 按消息代码分组: 仅保留最新消息
+	queue.open = true;
+	queue.Wait(1);
+	queue.Stop();
+
+	BOOST_CHECK_EQUAL(queue.handled.load(), 1);
+	BOOST_CHECK_EQUAL(queue.temp[2], 20);
+}
+
+BOOST_AUTO_TEST_CASE(payload_slots_exhausted) {
+	TestQueue queue;
+	MQPayloadPtr blob(new int(0));
+	BOOST_REQUIRE(queue.SetWorkers(1));
+	BOOST_REQUIRE(queue.Start("test_mq", MessageQueue::MQ_INPROC));
+
+	BOOST_REQUIRE(queue.PostPayload(TestQueue::MSG_BLOB, blob, sizeof(int)));
+	while (!queue.blocked.load()) std::this_thread::yield();
+	int accepted(1), rejected(0);
+	for (int i = 0; i < 3000; ++i) {// 交替使用两个优先级, 避免单一队列写满
+		bool rslt = i % 2 ? queue.SendPayload(TestQueue::MSG_BLOB, blob, sizeof(int))
+				: queue.PostPayload(TestQueue::MSG_BLOB, blob, sizeof(int));
+		if (rslt) ++accepted;
+		else ++rejected;
+	}
+	BOOST_CHECK(rejected > 0);	// 槽位耗尽时返回false, 不等待
+
+	queue.open = true;
+	while (queue.blobs.load() < accepted) std::this_thread::yield();
+	BOOST_CHECK(queue.PostPayload(TestQueue::MSG_BLOB, blob, sizeof(int)));	// 槽位已归还
+	while (queue.blobs.load() < accepted + 1) std::this_thread::yield();
+	queue.Stop();
+	BOOST_CHECK_EQUAL(blob.use_count(), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
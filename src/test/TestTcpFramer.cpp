@@ -0,0 +1,158 @@
+/**
+ * @file TestTcpFramer.cpp TcpFramer的单元测试
+ * @version 0.1
+ * @date 2026-10-16
+ */
+
+#include <string>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include "../TcpFramer.h"
+
+static std::string frame_str(ByteRing& ring, size_t from, size_t offset, size_t len) {
+	Frame frame;
+	ring.range(from + offset, len, frame.one, frame.two);
+	std::string s(frame.size(), 0);
+	frame.copy(&s[0]);
+	return s;
+}
+
+BOOST_AUTO_TEST_SUITE(TcpFramerTest)
+
+BOOST_AUTO_TEST_CASE(line_frames) {
+	ByteRing ring(64);
+	TcpFramerLine line;
+	size_t offset(0), len(0);
+	ring.push_back("cmd1\ncmd2\npart", 14);
+
+	BOOST_CHECK_EQUAL(line.Next(ring, 0, offset, len), 5);
+	BOOST_CHECK_EQUAL(frame_str(ring, 0, offset, len), "cmd1");
+	BOOST_CHECK_EQUAL(line.Next(ring, 5, offset, len), 5);
+	BOOST_CHECK_EQUAL(frame_str(ring, 5, offset, len), "cmd2");
+	BOOST_CHECK_EQUAL(line.Next(ring, 10, offset, len), 0);	// 不完整
+}
+
+BOOST_AUTO_TEST_CASE(line_keep_delimiter) {
+	ByteRing ring(64);
+	TcpFramerLine line("\r\n", true);
+	size_t offset(0), len(0);
+	ring.push_back("ok\r\n", 4);
+	BOOST_CHECK_EQUAL(line.Next(ring, 0, offset, len), 4);
+	BOOST_CHECK_EQUAL(frame_str(ring, 0, offset, len), "ok\r\n");
+}
+
+BOOST_AUTO_TEST_CASE(line_longer_than_ring) {
+	ByteRing ring(8);
+	TcpFramerLine line;
+	size_t offset(0), len(0);
+	ring.push_back("abcdefgh", 8);		// 缓冲区已满仍无分隔符
+	BOOST_CHECK_EQUAL(line.Next(ring, 0, offset, len), -1);
+
+	ring.clear();
+	ring.push_back("ab\ncdefg", 8);
+	BOOST_CHECK_EQUAL(line.Next(ring, 0, offset, len), 3);
+	BOOST_CHECK_EQUAL(line.Next(ring, 3, offset, len), 0);	// 剩余数据未占满缓冲区
+}
+
+BOOST_AUTO_TEST_CASE(length_prefix) {
+	ByteRing ring(64);
+	TcpFramerLength framer(2, 16);
+	size_t offset(0), len(0);
+	const char data[] = { 0, 3, 'a', 'b', 'c', 0, 4, 'x' };
+	ring.push_back(data, sizeof(data));
+
+	BOOST_CHECK_EQUAL(framer.Next(ring, 0, offset, len), 5);
+	BOOST_CHECK_EQUAL(offset, 2u);
+	BOOST_CHECK_EQUAL(frame_str(ring, 0, offset, len), "abc");
+	BOOST_CHECK_EQUAL(framer.Next(ring, 5, offset, len), 0);	// 不完整
+
+	ring.clear();
+	const char bad[] = { 0, 17 };		// 超出最大长度
+	ring.push_back(bad, sizeof(bad));
+	BOOST_CHECK_EQUAL(framer.Next(ring, 0, offset, len), -1);
+}
+
+BOOST_AUTO_TEST_CASE(length_prefix_widths) {
+	ByteRing ring(64);
+	size_t offset(0), len(0);
+	const char one[] = { 2, 'h', 'i' };
+	ring.push_back(one, sizeof(one));
+	BOOST_CHECK_EQUAL(TcpFramerLength(1).Next(ring, 0, offset, len), 3);
+	BOOST_CHECK_EQUAL(frame_str(ring, 0, offset, len), "hi");
+
+	ring.clear();
+	const char four[] = { 0, 0, 0, 1, 'z' };
+	ring.push_back(four, sizeof(four));
+	BOOST_CHECK_EQUAL(TcpFramerLength(4).Next(ring, 0, offset, len), 5);
+	BOOST_CHECK_EQUAL(frame_str(ring, 0, offset, len), "z");
+
+	ring.clear();
+	const char big[] = { 0, 0, 1, 0 };	// 256字节: 超出缓冲区容量
+	ring.push_back(big, sizeof(big));
+	BOOST_CHECK_EQUAL(TcpFramerLength(4, 1024).Next(ring, 0, offset, len), -1);
+}
+
+BOOST_AUTO_TEST_CASE(fixed_records) {
+	ByteRing ring(16);
+	TcpFramerFixed framer(4);
+	size_t offset(0), len(0);
+	ring.push_back("abcdefg", 7);
+	BOOST_CHECK_EQUAL(framer.Next(ring, 0, offset, len), 4);
+	BOOST_CHECK_EQUAL(frame_str(ring, 0, offset, len), "abcd");
+	BOOST_CHECK_EQUAL(framer.Next(ring, 4, offset, len), 0);
+	BOOST_CHECK_EQUAL(TcpFramerFixed(32).Next(ring, 0, offset, len), -1);
+}
+
+/*!
+ * @brief 以Feed()写入数据, 收集交付的帧
+ */
+static bool feed(TcpFramer& framer, ByteRing& ring, const std::string& data, std::vector<std::string>& out) {
+	std::vector<Frame> frames;
+	return framer.Feed(ring, data.data(), data.size(), frames, [&out](std::vector<Frame>& frames) {
+		for (size_t i = 0; i < frames.size(); ++i) {
+			std::string s(frames[i].size(), 0);
+			frames[i].copy(&s[0]);
+			out.push_back(s);
+		}
+	});
+}
+
+BOOST_AUTO_TEST_CASE(feed_partial_then_wrap) {
+	ByteRing ring(100);
+	TcpFramerLine line;
+	std::vector<std::string> out;
+	std::string packet(20, 'b');
+
+	BOOST_CHECK(feed(line, ring, std::string(90, 'a'), out));	// 不完整的行
+	packet[15] = '\n';		// 实际行长105字节, 超出缓冲区容量
+	BOOST_CHECK(!feed(line, ring, packet, out));
+	BOOST_CHECK(out.empty());
+	BOOST_CHECK(ring.empty());
+
+	packet[15] = 'b';
+	packet[5] = '\n';		// 行长95字节: 可以交付, 剩余数据保留
+	BOOST_CHECK(feed(line, ring, std::string(90, 'a'), out));
+	BOOST_CHECK(feed(line, ring, packet, out));
+	BOOST_REQUIRE_EQUAL(out.size(), 1u);
+	BOOST_CHECK_EQUAL(out[0], std::string(90, 'a') + std::string(5, 'b'));
+	BOOST_CHECK_EQUAL(ring.size(), 14u);
+}
+
+BOOST_AUTO_TEST_CASE(feed_length_header_kept) {
+	ByteRing ring(16);
+	TcpFramerLength framer(2);
+	std::vector<std::string> out;
+	std::string data("\0\x0A" "0123456789" "\0\x03" "xyz", 17);	// 两帧总长超出缓冲区容量
+
+	BOOST_CHECK(feed(framer, ring, data.substr(0, 9), out));
+	BOOST_CHECK(feed(framer, ring, data.substr(9), out));
+	BOOST_REQUIRE_EQUAL(out.size(), 2u);
+	BOOST_CHECK_EQUAL(out[0], "0123456789");
+	BOOST_CHECK_EQUAL(out[1], "xyz");
+	BOOST_CHECK(ring.empty());
+
+	const char big[] = { 0, 15, 'a' };	// 帧长17字节, 超出缓冲区容量
+	BOOST_CHECK(!feed(framer, ring, std::string(big, sizeof(big)), out));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
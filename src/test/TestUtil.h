@@ -0,0 +1,90 @@
+/**
+ * @file TestUtil.h 单元测试的公共工具
+ * @version 0.1
+ * @date 2026-10-16
+ */
+
+#ifndef SRC_TEST_TESTUTIL_H_
+#define SRC_TEST_TESTUTIL_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <string>
+#include <vector>
+
+/*!
+ * @class TestDir 临时目录, 析构时删除
+ */
+class TestDir {
+protected:
+	std::string path_;	///< 目录路径, 以'/'结尾
+
+public:
+	TestDir() {
+		char tmpl[] = "/tmp/lxmlib_test.XXXXXX";
+		if (mkdtemp(tmpl)) path_ = std::string(tmpl) + "/";
+	}
+
+	virtual ~TestDir() {
+		if (!path_.empty()) {
+			std::string cmd = "rm -rf " + path_;
+			if (system(cmd.c_str())) {}
+		}
+	}
+
+	const std::string& Path() const {
+		return path_;
+	}
+};
+
+/*!
+ * @brief 读取文本文件的全部行, 不含换行符
+ */
+inline std::vector<std::string> test_lines(const std::string& path) {
+	std::vector<std::string> lines;
+	FILE* fp = fopen(path.c_str(), "r");
+	char buf[1024];
+	if (!fp) return lines;
+	while (fgets(buf, sizeof(buf), fp)) {
+		std::string line(buf);
+		if (!line.empty() && line[line.size() - 1] == '\n') line.erase(line.size() - 1);
+		lines.push_back(line);
+	}
+	fclose(fp);
+	return lines;
+}
+
+/*!
+ * @brief 查找目录中扩展名为suffix的第一个文件
+ * @return
+ * 文件路径. 不存在时返回空字符串
+ */
+inline std::string test_find(const std::string& dir, const char* suffix) {
+	std::string path;
+	DIR* dp = opendir(dir.c_str());
+	struct dirent* ent;
+	size_t n = strlen(suffix);
+	if (!dp) return path;
+	while (path.empty() && (ent = readdir(dp)) != NULL) {
+		size_t len = strlen(ent->d_name);
+		if (len > n && !strcmp(ent->d_name + len - n, suffix)) path = dir + ent->d_name;
+	}
+	closedir(dp);
+	return path;
+}
+
+/*!
+ * @brief 读取临时文件的全部内容
+ */
+inline std::string test_read(FILE* fp) {
+	std::string text;
+	char buf[1024];
+	size_t n;
+	rewind(fp);
+	while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) text.append(buf, n);
+	return text;
+}
+
+#endif /* SRC_TEST_TESTUTIL_H_ */